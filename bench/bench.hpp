@@ -0,0 +1,57 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <string>
+
+// builds a program of num_lines lines that uses every form of the relaxed syntax in README.txt
+inline std::string generate_program(const long long num_lines)
+{
+    const std::string LINES[] = {
+        "      | LI   | R1,100h",
+        "LOOP%: | LW   | R3,0(R1)",
+        "  addi r5, r5, 1\r",
+        "mult R6,R5,R6",
+        "|SUBI| R7 , R7 , 0x2h",
+        "sw r6, R1(4)",
+        "",
+        "LABEL%:",
+        "AddR2,R2,R3",
+        "  BNE R5, R3, LOOP%",
+        "BEQ R0, R0, 3",
+        "J LABEL%"};
+    const int NUM_FORMS = sizeof(LINES) / sizeof(LINES[0]);
+
+    std::string source;
+    for (long long ii = 0; ii < num_lines; ii++)
+    {
+        // labels are numbered per block so every one stays unique
+        std::string line = LINES[ii % NUM_FORMS];
+        size_t marker = line.find('%');
+        if (marker != std::string::npos)
+        {
+            line.replace(marker, 1, std::to_string(ii / NUM_FORMS));
+        }
+        source += line;
+        source += '\n';
+    }
+    source += "HLT";
+    return source;
+}
+
+// builds a data file of num_words words in the original 32 digit binary format
+inline std::string generate_data(const long long num_words)
+{
+    std::string source;
+    source.reserve(num_words * 33);
+    for (long long ii = 0; ii < num_words; ii++)
+    {
+        for (int jj = 31; jj >= 0; jj--)
+        {
+            source += (ii * 2654435761u >> jj) & 1 ? '1' : '0';
+        }
+        source += '\n';
+    }
+    return source;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "functional.hpp"
+#include "memory.hpp"
+#include "options.hpp"
+#include "program.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+
+// measures how many cycles the timing model simulates per second, on the bundled default_inst.txt loop
+// the loop bound is the data word default_inst.txt loads, so scaling it up only makes the run longer
+// usage: cycle_bench [num_iterations] [num_runs] [pipeline]
+
+const string PROGRAM_FILE = "bin/default_inst.txt";
+const string OUTPUT_FILE = "/dev/null";
+const long long DEFAULT_NUM_ITERATIONS = 1000000;
+const int DEFAULT_NUM_RUNS = 3;
+
+int main(const int argc, const char* argv[])
+{
+    long long num_iterations = argc > 1 ? std::stoll(argv[1]) : DEFAULT_NUM_ITERATIONS;
+    int num_runs = argc > 2 ? std::stoi(argv[2]) : DEFAULT_NUM_RUNS;
+
+    Options options;
+    options.cycle_limit = 0;
+    options.echo_output = false;
+    if (argc > 3)
+    {
+        options.pipeline = find_pipeline_config(argv[3]);
+        if (not options.pipeline)
+        {
+            cout << "ERROR: unknown pipeline \"" << argv[3] << "\"!" << endl;
+            return 1;
+        }
+    }
+
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    load_program(*program, PROGRAM_FILE);
+    if (program->instructions.empty())
+    {
+        return 1;
+    }
+
+    long long num_cycles = 0;
+    double best_seconds = 0;
+    for (int ii = 0; ii < num_runs; ii++)
+    {
+        // R1 is 100h, so the LW of the loop bound reads the first data word
+        Memory memory;
+        memory.program = program;
+        load_segment(memory.data, std::vector<std::bitset<REG_SIZE>>(1, num_iterations + 1));
+
+        FunctionalState functional;
+        TraceSource source;
+        start_functional(functional, memory);
+        open_live_source(source, functional, memory);
+
+        auto start = std::chrono::steady_clock::now();
+        num_cycles = run_timing(*program, source, options, OUTPUT_FILE);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (ii == 0 || elapsed.count() < best_seconds)
+        {
+            best_seconds = elapsed.count();
+        }
+    }
+
+    cout << "simulated " << num_cycles << " cycles of the " << options.pipeline->name << " stage pipeline in " << best_seconds << " s" << endl;
+    cout << "simulation speed: " << num_cycles / best_seconds / 1e6 << " M cycles/s" << endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "functional.hpp"
+#include "memory.hpp"
+#include "program.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+
+// measures how many instructions functional mode executes per second, interpreted and with hot blocks translated
+// runs the bundled default_inst.txt loop, whose bound is the data word it loads
+// usage: functional_bench [num_iterations] [num_runs]
+
+const string PROGRAM_FILE = "bin/default_inst.txt";
+const long long DEFAULT_NUM_ITERATIONS = 100000000;
+const int DEFAULT_NUM_RUNS = 3;
+
+// best of num_runs, leaves the final registers of the last run in registers
+double time_functional(const std::shared_ptr<Program>& program, const long long num_iterations, const int num_runs, const bool use_jit, long long& executed, std::vector<std::bitset<REG_SIZE>>& registers)
+{
+    double best_seconds = 0;
+    for (int ii = 0; ii < num_runs; ii++)
+    {
+        // R1 is 100h, so the LW of the loop bound reads the first data word
+        Memory memory;
+        memory.program = program;
+        load_segment(memory.data, std::vector<std::bitset<REG_SIZE>>(1, num_iterations + 1));
+
+        auto start = std::chrono::steady_clock::now();
+        executed = run_functional(memory, use_jit);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (ii == 0 || elapsed.count() < best_seconds)
+        {
+            best_seconds = elapsed.count();
+        }
+        registers = memory.registers;
+    }
+    return best_seconds;
+}
+
+int main(const int argc, const char* argv[])
+{
+    long long num_iterations = argc > 1 ? std::stoll(argv[1]) : DEFAULT_NUM_ITERATIONS;
+    int num_runs = argc > 2 ? std::stoi(argv[2]) : DEFAULT_NUM_RUNS;
+
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    load_program(*program, PROGRAM_FILE);
+    if (program->instructions.empty())
+    {
+        return 1;
+    }
+
+    long long interpreted;
+    long long translated;
+    std::vector<std::bitset<REG_SIZE>> interpreted_registers;
+    std::vector<std::bitset<REG_SIZE>> translated_registers;
+    double interpreter_seconds = time_functional(program, num_iterations, num_runs, false, interpreted, interpreted_registers);
+    double jit_seconds = time_functional(program, num_iterations, num_runs, true, translated, translated_registers);
+
+    if (interpreted != translated || interpreted_registers != translated_registers)
+    {
+        cout << "ERROR: the translated run did not end in the same state as the interpreted one!" << endl;
+        return 1;
+    }
+
+    cout << "executed " << interpreted << " instructions" << endl;
+    cout << "interpreter: " << interpreted / interpreter_seconds / 1e6 << " M instructions/s" << endl;
+    cout << "jit: " << translated / jit_seconds / 1e6 << " M instructions/s" << (jit_supported() ? "" : " (not supported on this host, interpreted)") << endl;
+    cout << "speedup: " << interpreter_seconds / jit_seconds << "x" << endl;
+    return 0;
+}
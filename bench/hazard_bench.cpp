@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "pipeline.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::vector;
+
+// measures the cost of one data hazard check, scanning every stage against the scoreboard's single AND
+// usage: hazard_bench [num_checks]
+
+const long long DEFAULT_NUM_CHECKS = 100000000;
+const int NUM_STATES = 1024; // distinct pipelines cycled through so the checks can not be hoisted
+
+// the check update_data_hazards() used to make (with source_reg2 compared as well)
+// every stage past IF is compared against the sources of the instruction in IF
+bool scan_for_hazard(const Pipeline& pipeline, const int num_stages)
+{
+    const Instruction* fetched = pipeline.active_instrs[IF];
+    bool hazard = false;
+    for (Stage ii = num_stages - 1; ii >= 1; ii--)
+    {
+        const Instruction* ahead = pipeline.active_instrs[ii];
+        if (ahead && ahead->writes_to_register && not ahead->already_wrote_result)
+        {
+            if (ahead->result_reg == fetched->source_reg1 || ahead->result_reg == fetched->source_reg2)
+            {
+                hazard = true;
+            }
+        }
+    }
+    return hazard;
+}
+
+// fills every stage with a random ALU instruction and issues the ones past ID, like the timing loop would
+void fill_random_state(Pipeline& pipeline, std::mt19937& random, const int num_stages)
+{
+    std::uniform_int_distribution<int> reg(0, NUM_REGS - 1);
+    for (Stage ii = num_stages - 1; ii >= 0; ii--)
+    {
+        Instruction& instruction = pipeline.window[ii];
+        instruction.instr_index = num_stages - 1 - ii;
+        instruction.result_reg = reg(random);
+        instruction.source_reg1 = reg(random);
+        instruction.source_reg2 = reg(random);
+        instruction.source_mask = register_mask(instruction.source_reg1) | register_mask(instruction.source_reg2);
+        instruction.writes_to_register = true;
+        instruction.exists = true;
+        pipeline.active_instrs[ii] = &instruction;
+        if (ii > ID)
+        {
+            issue_to_scoreboard(pipeline, instruction);
+        }
+    }
+}
+
+template <typename CHECK>
+double time_checks(const vector<Pipeline>& states, const long long num_checks, CHECK check, long long& num_hazards)
+{
+    auto start = std::chrono::steady_clock::now();
+    num_hazards = 0;
+    for (long long ii = 0; ii < num_checks; ii++)
+    {
+        num_hazards += check(states[ii % NUM_STATES]);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(const int argc, const char* argv[])
+{
+    long long num_checks = argc > 1 ? std::stoll(argv[1]) : DEFAULT_NUM_CHECKS;
+    const int num_stages = DEFAULT_PIPELINE->num_stages;
+
+    std::mt19937 random(411);
+    vector<Pipeline> states = vector<Pipeline>(NUM_STATES);
+    for (Pipeline& state : states)
+    {
+        fill_random_state(state, random, num_stages);
+    }
+
+    long long scan_hazards;
+    long long scoreboard_hazards;
+    double scan_seconds = time_checks(states, num_checks, [num_stages](const Pipeline& pipeline) { return scan_for_hazard(pipeline, num_stages); }, scan_hazards);
+    double scoreboard_seconds = time_checks(states, num_checks, [](const Pipeline& pipeline) { return data_hazard_exists(pipeline, IF, pipeline.pending_writes); }, scoreboard_hazards);
+
+    if (scan_hazards != scoreboard_hazards)
+    {
+        cout << "ERROR: scan found " << scan_hazards << " hazards, scoreboard found " << scoreboard_hazards << "!" << endl;
+        return 1;
+    }
+
+    cout << "stage scan: " << scan_seconds * 1e9 / num_checks << " ns per check" << endl;
+    cout << "scoreboard: " << scoreboard_seconds * 1e9 / num_checks << " ns per check" << endl;
+    cout << "speedup: " << scan_seconds / scoreboard_seconds << "x" << endl;
+    return 0;
+}
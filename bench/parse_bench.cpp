@@ -0,0 +1,46 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "program.hpp"
+#include "utils.hpp"
+#include "bench.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+
+// measures how fast programs are lexed and decoded, in MB of source text per second
+// usage: parse_bench [num_lines] [num_runs]
+
+const long long DEFAULT_NUM_LINES = 2000000;
+const int DEFAULT_NUM_RUNS = 5;
+
+int main(const int argc, const char* argv[])
+{
+    long long num_lines = argc > 1 ? std::stoll(argv[1]) : DEFAULT_NUM_LINES;
+    int num_runs = argc > 2 ? std::stoi(argv[2]) : DEFAULT_NUM_RUNS;
+
+    string source = generate_program(num_lines);
+    double megabytes = source.size() / 1e6;
+    double best_seconds = 0;
+
+    for (int ii = 0; ii < num_runs; ii++)
+    {
+        // read through a stream, the same path a piped program takes
+        std::istringstream in(source);
+        Program program;
+
+        auto start = std::chrono::steady_clock::now();
+        load_program(program, in);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (ii == 0 || elapsed.count() < best_seconds)
+        {
+            best_seconds = elapsed.count();
+        }
+    }
+
+    cout << "parsed " << num_lines << " lines (" << megabytes << " MB) in " << best_seconds << " s" << endl;
+    cout << "parse throughput: " << megabytes / best_seconds << " MB/s" << endl;
+    return 0;
+}
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// writes a synthetic program and its data segment, for finding where the simulator stops scaling
+// the program is one loop body repeated until about --instructions= have run, every choice in it comes from --seed=
+// usage: stress_gen [--instructions=N] [--body=N] [--distance=N] [--branches=F] [--taken=F]
+//                   [--memory=F] [--stores=F] [--footprint=BYTES] [--seed=N] <instruction_file> <data_file>
+
+const string INSTRUCTIONS_FLAG = "--instructions="; // dynamic instructions to run, roughly
+const string BODY_FLAG = "--body="; // slots in the loop body, a branch slot is a LW and a BNE
+const string DISTANCE_FLAG = "--distance="; // instructions between a result and its first reader, 0 for none
+const string BRANCHES_FLAG = "--branches="; // share of slots that branch forward over the next 1 to MAX_SKIP slots
+const string TAKEN_FLAG = "--taken="; // share of those branches that are taken
+const string MEMORY_FLAG = "--memory="; // share of the other slots that are LW or SW
+const string STORES_FLAG = "--stores="; // share of those that are SW
+const string FOOTPRINT_FLAG = "--footprint="; // bytes of data the loads and stores sweep through
+const string SEED_FLAG = "--seed=";
+
+const int DATA_SEGMENT_START = 256; // where the simulator loads the data file
+const int MAX_SKIP = 3;
+const int TABLE_ITERATIONS = 256; // iterations of branch outcomes kept in the data segment before they repeat
+
+// registers the loop keeps for itself, the body's results rotate through the rest
+const int ITERATION_REG = 2;
+const int LIMIT_REG = 3;
+const int TABLE_REG = 4; // next iteration's branch outcomes
+const int TABLE_END_REG = 5;
+const int CONDITION_REG = 6;
+const int WALK_REG = 7; // next iteration's slice of the footprint
+const int WALK_END_REG = 9;
+const int FIRST_POOL_REG = 10;
+const int NUM_POOL_REGS = 32 - FIRST_POOL_REG;
+
+struct StressConfig {
+    long long num_instructions = 1000000;
+    int body_slots = 64;
+    int distance = 1;
+    double branches = 0.1;
+    double taken = 0.5;
+    double memory = 0.3;
+    double stores = 0.3;
+    long long footprint = 4096;
+    unsigned int seed = 1;
+};
+
+enum SlotKind {SLOT_ALU, SLOT_LOAD, SLOT_STORE, SLOT_BRANCH};
+
+struct Slot {
+    SlotKind kind = SLOT_ALU;
+    int skip = 0; // slots a branch jumps over when taken, its target is the slot after them
+    bool is_target = false;
+};
+
+// the register a source reads, the result of the latest producer at least distance instructions back
+// producers is every (position, register) written so far, R0 if none is far enough back
+static int pick_source(const vector<std::pair<int, int>>& producers, const int position, const int distance, const int extra)
+{
+    if (distance == 0)
+    {
+        return 0;
+    }
+    int found = 0;
+    for (auto it = producers.rbegin(); it != producers.rend(); it++)
+    {
+        if (it->first <= position - distance - extra)
+        {
+            found = it->second;
+            break;
+        }
+    }
+    return found;
+}
+
+static bool parse_flag(const string& arg, const string& flag, double& value)
+{
+    if (arg.starts_with(flag))
+    {
+        value = std::stod(arg.substr(flag.length()));
+        return true;
+    }
+    return false;
+}
+
+static bool parse_flag(const string& arg, const string& flag, long long& value)
+{
+    if (arg.starts_with(flag))
+    {
+        value = std::stoll(arg.substr(flag.length()));
+        return true;
+    }
+    return false;
+}
+
+int main(const int argc, const char* argv[])
+{
+    StressConfig config;
+    vector<string> filenames;
+    for (int ii = 1; ii < argc; ii++)
+    {
+        string arg = argv[ii];
+        long long integer = 0;
+        if (parse_flag(arg, INSTRUCTIONS_FLAG, config.num_instructions) || parse_flag(arg, FOOTPRINT_FLAG, config.footprint)
+            || parse_flag(arg, BRANCHES_FLAG, config.branches) || parse_flag(arg, TAKEN_FLAG, config.taken)
+            || parse_flag(arg, MEMORY_FLAG, config.memory) || parse_flag(arg, STORES_FLAG, config.stores))
+        {
+            continue;
+        }
+        if (parse_flag(arg, BODY_FLAG, integer))
+        {
+            config.body_slots = integer;
+        }
+        else if (parse_flag(arg, DISTANCE_FLAG, integer))
+        {
+            config.distance = integer;
+        }
+        else if (parse_flag(arg, SEED_FLAG, integer))
+        {
+            config.seed = integer;
+        }
+        else
+        {
+            filenames.push_back(arg);
+        }
+    }
+
+    if (filenames.size() != 2)
+    {
+        cout << "ERROR: stress_gen needs an instruction file and a data file to write!" << endl;
+        return 1;
+    }
+    if (config.body_slots < 1 || config.num_instructions < 1 || config.footprint < 4)
+    {
+        cout << "ERROR: the body, instruction count and footprint must be positive!" << endl;
+        return 1;
+    }
+    if (config.distance < 0 || config.distance >= NUM_POOL_REGS)
+    {
+        cout << "ERROR: the dependency distance must be between 0 and " << NUM_POOL_REGS - 1 << "!" << endl;
+        return 1;
+    }
+    for (double share : {config.branches, config.taken, config.memory, config.stores})
+    {
+        if (share < 0 || share > 1)
+        {
+            cout << "ERROR: shares must be between 0 and 1!" << endl;
+            return 1;
+        }
+    }
+
+    // pick what every slot of the body does
+    std::mt19937 random(config.seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    vector<Slot> slots(config.body_slots);
+    int num_branches = 0;
+    int num_accesses = 0;
+    for (int ii = 0; ii < config.body_slots; ii++)
+    {
+        Slot& slot = slots[ii];
+        // a taken BNE carries on from its target, so skipping a slot needs a slot after it to land on
+        int room = config.body_slots - 1 - ii;
+        if (room >= 2 && chance(random) < config.branches)
+        {
+            slot.kind = SLOT_BRANCH;
+            slot.skip = std::uniform_int_distribution<int>(1, std::min(MAX_SKIP, room - 1))(random);
+            slots[ii + slot.skip + 1].is_target = true;
+            num_branches++;
+        }
+        else if (chance(random) < config.memory)
+        {
+            slot.kind = chance(random) < config.stores ? SLOT_STORE : SLOT_LOAD;
+            num_accesses++;
+        }
+    }
+
+    // each iteration loads and stores the next slice of the footprint, wrapping at its end
+    long long slice = 4LL * std::max(num_accesses, 1);
+    long long footprint = std::max(slice, config.footprint / slice * slice);
+    long long table_start = DATA_SEGMENT_START + footprint;
+    long long table_size = 4LL * num_branches * TABLE_ITERATIONS;
+
+    // LW and BNE per branch, plus the loop's own bookkeeping
+    int instructions_per_iteration = config.body_slots + num_branches + 2 + (num_accesses > 0 ? 3 : 0) + (num_branches > 0 ? 3 : 0);
+    long long num_iterations = std::max(1LL, config.num_instructions / instructions_per_iteration);
+
+    std::ofstream program(filenames[0], std::ofstream::trunc);
+    program << "        LI   R" << ITERATION_REG << ",0" << endl;
+    program << "        LI   R" << LIMIT_REG << "," << num_iterations << endl;
+    program << "        LI   R" << WALK_REG << "," << DATA_SEGMENT_START << endl;
+    program << "        LI   R" << WALK_END_REG << "," << DATA_SEGMENT_START + footprint << endl;
+    program << "        LI   R" << TABLE_REG << "," << table_start << endl;
+    program << "        LI   R" << TABLE_END_REG << "," << table_start + table_size << endl;
+
+    const string ALU_OPCODES[] = {"ADD ", "SUB ", "MULT", "ADDI", "SUBI", "MULTI"};
+    vector<std::pair<int, int>> producers;
+    int position = 0;
+    int branch_index = 0;
+    int access_index = 0;
+    int next_pool_reg = 0;
+    for (int ii = 0; ii < config.body_slots; ii++)
+    {
+        const Slot& slot = slots[ii];
+        string label = ii == 0 ? "LOOP:" : slot.is_target ? "T" + std::to_string(ii) + ":" : "";
+        label.resize(8, ' ');
+        int source = pick_source(producers, position, config.distance, 0);
+        int result = FIRST_POOL_REG + next_pool_reg;
+
+        switch (slot.kind)
+        {
+        case SLOT_BRANCH:
+            program << label << "LW   R" << CONDITION_REG << "," << 4 * branch_index << "(R" << TABLE_REG << ")" << endl;
+            program << "        BNE  R" << CONDITION_REG << ",R0,T" << ii + slot.skip + 1 << endl;
+            branch_index++;
+            position += 2;
+            continue;
+        case SLOT_STORE:
+            program << label << "SW   R" << source << "," << 4 * access_index << "(R" << WALK_REG << ")" << endl;
+            access_index++;
+            position++;
+            continue;
+        case SLOT_LOAD:
+            program << label << "LW   R" << result << "," << 4 * access_index << "(R" << WALK_REG << ")" << endl;
+            access_index++;
+            break;
+        case SLOT_ALU:
+        {
+            const string& opcode = ALU_OPCODES[std::uniform_int_distribution<int>(0, 5)(random)];
+            program << label << opcode << " R" << result << ",R" << source << ",";
+            if (opcode.ends_with("I"))
+            {
+                program << std::uniform_int_distribution<int>(1, 15)(random) << endl;
+            }
+            else
+            {
+                program << "R" << pick_source(producers, position, config.distance, 1) << endl;
+            }
+            break;
+        }
+        }
+        producers.push_back({position, result});
+        next_pool_reg = (next_pool_reg + 1) % NUM_POOL_REGS;
+        position++;
+    }
+
+    // the loop's own bookkeeping never reads the body's results, so --distance= only shapes the body
+    if (num_accesses > 0)
+    {
+        program << "        ADDI R" << WALK_REG << ",R" << WALK_REG << "," << slice << endl;
+        program << "        BNE  R" << WALK_REG << ",R" << WALK_END_REG << ",WALKED" << endl;
+        program << "        LI   R" << WALK_REG << "," << DATA_SEGMENT_START << endl;
+        program << "WALKED: ADDI R" << ITERATION_REG << ",R" << ITERATION_REG << ",0" << endl;
+    }
+    if (num_branches > 0)
+    {
+        program << "        ADDI R" << TABLE_REG << ",R" << TABLE_REG << "," << 4 * num_branches << endl;
+        program << "        BNE  R" << TABLE_REG << ",R" << TABLE_END_REG << ",TURNED" << endl;
+        program << "        LI   R" << TABLE_REG << "," << table_start << endl;
+        program << "TURNED: ADDI R" << ITERATION_REG << ",R" << ITERATION_REG << ",0" << endl;
+    }
+    program << "        ADDI R" << ITERATION_REG << ",R" << ITERATION_REG << ",1" << endl;
+    program << "        BNE  R" << ITERATION_REG << ",R" << LIMIT_REG << ",LOOP" << endl;
+    program << "        HLT" << endl;
+
+    // random words to load from the footprint, then the outcome of every branch for TABLE_ITERATIONS iterations
+    std::ofstream data(filenames[1], std::ofstream::trunc);
+    char word[16];
+    for (long long ii = 0; ii < footprint / 4; ii++)
+    {
+        snprintf(word, sizeof(word), "0x%08x", (unsigned int)random());
+        data << word << '\n';
+    }
+    vector<bool> outcomes(table_size / 4);
+    for (long long ii = 0; ii < table_size / 4; ii++)
+    {
+        outcomes[ii] = chance(random) < config.taken;
+        data << (outcomes[ii] ? "0x1" : "0x0") << '\n';
+    }
+
+    if (not program || not data)
+    {
+        cout << "ERROR: the program or data file could not be written!" << endl;
+        return 1;
+    }
+
+    // walks the body with the outcome table to count what a run executes, make stress-check compares it with the simulator
+    long long num_executed = 6 + 1; // the LIs before the loop and the HLT after it
+    long long num_run_branches = 0;
+    long long num_taken = 0;
+    vector<int> branch_numbers(config.body_slots);
+    for (int ii = 0, branch = 0; ii < config.body_slots; ii++)
+    {
+        branch_numbers[ii] = slots[ii].kind == SLOT_BRANCH ? branch++ : 0;
+    }
+    for (long long ii = 0; ii < num_iterations; ii++)
+    {
+        const long long row = (ii % TABLE_ITERATIONS) * num_branches;
+        int jj = 0;
+        while (jj < config.body_slots)
+        {
+            if (slots[jj].kind != SLOT_BRANCH)
+            {
+                num_executed++;
+                jj++;
+                continue;
+            }
+            bool taken = outcomes[row + branch_numbers[jj]];
+            num_executed += 2;
+            num_run_branches++;
+            num_taken += taken;
+            jj += taken ? slots[jj].skip + 1 : 1;
+        }
+
+        // each pointer is reset by its LI when it reaches the end of its table
+        num_executed += 2;
+        if (num_accesses > 0)
+        {
+            num_executed += 3 + ((ii + 1) * slice % footprint == 0);
+        }
+        if (num_branches > 0)
+        {
+            num_executed += 3 + ((ii + 1) % TABLE_ITERATIONS == 0);
+        }
+    }
+
+    cout << "wrote " << num_iterations << " iterations of a " << instructions_per_iteration << " instruction loop ("
+         << num_branches << " branches, " << num_accesses << " loads and stores over " << footprint << " bytes)" << endl;
+    cout << "expect " << num_executed << " instructions, " << num_taken << " of " << num_run_branches << " branches taken" << endl;
+    return 0;
+}
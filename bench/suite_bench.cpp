@@ -0,0 +1,383 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "functional.hpp"
+#include "memory.hpp"
+#include "options.hpp"
+#include "program.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+#include "bench.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// runs every workload the simulator is tuned for and reports its throughput and peak RSS
+// each workload runs in a child process of its own, so the peak RSS is that workload's alone
+// results are written one line per workload, so a baseline kept in git shows regressions as diffs
+// usage: suite_bench [--quick] [--out=<results.json>] [--baseline=<baseline.json>]
+
+const string DEFAULT_INST_FILE = "bin/default_inst.txt";
+const string PROGRAM_DIR = "bench/programs/";
+const string OUTPUT_FILE = "/dev/null";
+const string QUICK_FLAG = "--quick";
+const string OUT_FLAG = "--out=";
+const string BASELINE_FLAG = "--baseline=";
+
+// programs from example_MIPS_programs/ translated to the simulator's instructions, each with <name>_data.txt
+// the rest need DIV, REM, JAL or a less-than compare, which the simulator does not have
+const string EXAMPLE_PROGRAMS[] = {"arrays", "fact", "ifelse", "power", "swap"};
+
+const long long PARSE_LINES = 2000000;
+const long long PARSE_WORDS = 2000000;
+const long long DEFAULT_INST_ITERATIONS = 1000000;
+const int NUM_RUNS = 3;
+const int QUICK_SCALE = 10; // --quick divides the sizes by this and runs everything once
+
+// what one workload did in its fastest run, the child process hands it back to the parent whole
+struct Measurement {
+    double seconds = 0;
+    double megabytes = 0; // of text parsed
+    long long cycles = 0; // simulated
+    long long instructions = 0; // executed
+};
+
+struct Workload {
+    string name;
+    std::function<Measurement(const bool quick)> run;
+};
+
+// keeps the fastest of the runs, workloads only differ in what one run does
+static void keep_fastest(Measurement& best, const Measurement& run, const int run_index)
+{
+    if (run_index == 0 || run.seconds < best.seconds)
+    {
+        best = run;
+    }
+}
+
+static double seconds_since(const std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static Measurement parse_program_workload(const bool quick)
+{
+    string source = generate_program(quick ? PARSE_LINES / QUICK_SCALE : PARSE_LINES);
+    Measurement best;
+    for (int ii = 0; ii < (quick ? 1 : NUM_RUNS); ii++)
+    {
+        std::istringstream in(source);
+        Program program;
+
+        Measurement run;
+        auto start = std::chrono::steady_clock::now();
+        load_program(program, in);
+        run.seconds = seconds_since(start);
+        run.megabytes = source.size() / 1e6;
+        keep_fastest(best, run, ii);
+    }
+    return best;
+}
+
+static Measurement parse_data_workload(const bool quick)
+{
+    string source = generate_data(quick ? PARSE_WORDS / QUICK_SCALE : PARSE_WORDS);
+    string data_file = (std::filesystem::temp_directory_path() / ("suite_bench_" + std::to_string(getpid()) + ".txt")).string();
+    std::ofstream(data_file) << source;
+
+    Measurement best;
+    for (int ii = 0; ii < (quick ? 1 : NUM_RUNS); ii++)
+    {
+        vector<std::bitset<REG_SIZE>> data;
+
+        Measurement run;
+        auto start = std::chrono::steady_clock::now();
+        load_data(data, data_file);
+        run.seconds = seconds_since(start);
+        run.megabytes = source.size() / 1e6;
+        keep_fastest(best, run, ii);
+    }
+    std::remove(data_file.c_str());
+    return best;
+}
+
+// times the whole program through the pipeline, data_segment is what the functional engine starts with
+static Measurement time_program(const std::shared_ptr<Program>& program, const vector<std::bitset<REG_SIZE>>& data_segment, const PipelineConfig* pipeline, const int num_runs)
+{
+    Options options;
+    options.cycle_limit = 0;
+    options.echo_output = false;
+    options.pipeline = pipeline;
+
+    Measurement best;
+    for (int ii = 0; ii < num_runs; ii++)
+    {
+        Memory memory;
+        memory.program = program;
+        load_segment(memory.data, data_segment);
+
+        FunctionalState functional;
+        TraceSource source;
+        start_functional(functional, memory);
+        open_live_source(source, functional, memory);
+
+        Measurement run;
+        auto start = std::chrono::steady_clock::now();
+        run.cycles = run_timing(*program, source, options, OUTPUT_FILE);
+        run.seconds = seconds_since(start);
+        run.instructions = functional.executed;
+        keep_fastest(best, run, ii);
+    }
+    return best;
+}
+
+// functional mode with hot blocks translated, where the host supports it
+static Measurement run_program_functionally(const std::shared_ptr<Program>& program, const vector<std::bitset<REG_SIZE>>& data_segment, const int num_runs)
+{
+    Measurement best;
+    for (int ii = 0; ii < num_runs; ii++)
+    {
+        Memory memory;
+        memory.program = program;
+        load_segment(memory.data, data_segment);
+
+        Measurement run;
+        auto start = std::chrono::steady_clock::now();
+        run.instructions = run_functional(memory, true);
+        run.seconds = seconds_since(start);
+        keep_fastest(best, run, ii);
+    }
+    return best;
+}
+
+static Measurement default_inst_workload(const PipelineConfig* pipeline, const bool quick)
+{
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    load_program(*program, DEFAULT_INST_FILE);
+
+    // R1 is 100h, so the LW of the loop bound reads the first data word
+    long long num_iterations = quick ? DEFAULT_INST_ITERATIONS / QUICK_SCALE : DEFAULT_INST_ITERATIONS;
+    return time_program(program, vector<std::bitset<REG_SIZE>>(1, num_iterations + 1), pipeline, quick ? 1 : NUM_RUNS);
+}
+
+static Measurement example_workload(const string& name, const bool timed, const bool quick)
+{
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    vector<std::bitset<REG_SIZE>> data_segment;
+    load_program(*program, PROGRAM_DIR + name + ".txt");
+    load_data(data_segment, PROGRAM_DIR + name + "_data.txt");
+
+    int num_runs = quick ? 1 : NUM_RUNS;
+    return timed ? time_program(program, data_segment, DEFAULT_PIPELINE, num_runs) : run_program_functionally(program, data_segment, num_runs);
+}
+
+static vector<Workload> list_workloads()
+{
+    vector<Workload> workloads;
+    workloads.push_back({"parse-program", parse_program_workload});
+    workloads.push_back({"parse-data", parse_data_workload});
+    for (const PipelineConfig* pipeline : {&FIVE_STAGE_PIPELINE, &SEVEN_STAGE_PIPELINE, &NINE_STAGE_PIPELINE})
+    {
+        workloads.push_back({string("cycles-default-") + pipeline->name, [pipeline](const bool quick) { return default_inst_workload(pipeline, quick); }});
+    }
+    for (const string& name : EXAMPLE_PROGRAMS)
+    {
+        workloads.push_back({"cycles-" + name, [name](const bool quick) { return example_workload(name, true, quick); }});
+        workloads.push_back({"functional-" + name, [name](const bool quick) { return example_workload(name, false, quick); }});
+    }
+    return workloads;
+}
+
+// runs the workload in a child process, returns false if it did not finish
+static bool run_in_child(const Workload& workload, const bool quick, Measurement& measurement, long& peak_rss_kb)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return false;
+    }
+    cout.flush();
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        return false;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        Measurement result = workload.run(quick);
+        bool written = write(fds[1], &result, sizeof(result)) == sizeof(result);
+        cout.flush();
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool received = read(fds[0], &measurement, sizeof(measurement)) == sizeof(measurement);
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage = {};
+    wait4(pid, &status, 0, &usage);
+    peak_rss_kb = usage.ru_maxrss;
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// every metric of a workload by name, in the order they are written
+static vector<std::pair<string, double>> list_metrics(const Measurement& measurement, const long peak_rss_kb)
+{
+    vector<std::pair<string, double>> metrics;
+    if (measurement.megabytes > 0)
+    {
+        metrics.push_back({"mb_per_s", measurement.megabytes / measurement.seconds});
+    }
+    if (measurement.cycles > 0)
+    {
+        metrics.push_back({"cycles_per_s", measurement.cycles / measurement.seconds});
+    }
+    if (measurement.instructions > 0)
+    {
+        metrics.push_back({"instructions_per_s", measurement.instructions / measurement.seconds});
+    }
+    metrics.push_back({"peak_rss_kb", (double)peak_rss_kb});
+    return metrics;
+}
+
+// reads back the metrics of every workload in a file written by this benchmark, keyed by workload name
+static std::map<string, std::map<string, double>> read_results(const string& filename)
+{
+    std::map<string, std::map<string, double>> results;
+    std::ifstream file(filename);
+    string line;
+    while (std::getline(file, line))
+    {
+        const string NAME_KEY = "\"name\": \"";
+        size_t name_start = line.find(NAME_KEY);
+        if (name_start == string::npos)
+        {
+            continue;
+        }
+        name_start += NAME_KEY.length();
+        string name = line.substr(name_start, line.find('"', name_start) - name_start);
+
+        // every other "key": number pair on the line
+        size_t key_start = line.find('"', line.find('"', name_start) + 1);
+        while (key_start != string::npos)
+        {
+            size_t key_end = line.find('"', key_start + 1);
+            size_t value_start = line.find(':', key_end) + 1;
+            if (key_end == string::npos || value_start == 0)
+            {
+                break;
+            }
+            results[name][line.substr(key_start + 1, key_end - key_start - 1)] = std::strtod(line.c_str() + value_start, nullptr);
+            key_start = line.find('"', value_start);
+        }
+    }
+    return results;
+}
+
+int main(const int argc, const char* argv[])
+{
+    bool quick = false;
+    string out_file;
+    string baseline_file;
+    for (int ii = 1; ii < argc; ii++)
+    {
+        string arg = argv[ii];
+        if (arg == QUICK_FLAG)
+        {
+            quick = true;
+        }
+        else if (arg.starts_with(OUT_FLAG))
+        {
+            out_file = arg.substr(OUT_FLAG.length());
+        }
+        else if (arg.starts_with(BASELINE_FLAG))
+        {
+            baseline_file = arg.substr(BASELINE_FLAG.length());
+        }
+        else
+        {
+            cout << "ERROR: unknown argument \"" << arg << "\"!" << endl;
+            return 1;
+        }
+    }
+
+    std::map<string, std::map<string, double>> baseline;
+    if (not baseline_file.empty())
+    {
+        baseline = read_results(baseline_file);
+        if (baseline.empty())
+        {
+            cout << "no baseline in " << baseline_file << ", nothing to compare with" << endl;
+        }
+    }
+
+    std::ostringstream json;
+    json << "{" << endl << "  \"benchmarks\": [";
+    bool all_finished = true;
+    bool first = true;
+    vector<Workload> workloads = list_workloads();
+    for (unsigned int ii = 0; ii < workloads.size(); ii++)
+    {
+        const Workload& workload = workloads[ii];
+        Measurement measurement;
+        long peak_rss_kb = 0;
+        if (not run_in_child(workload, quick, measurement, peak_rss_kb))
+        {
+            cout << "ERROR: " << workload.name << " did not finish!" << endl;
+            all_finished = false;
+            continue;
+        }
+
+        vector<std::pair<string, double>> metrics = list_metrics(measurement, peak_rss_kb);
+        json << (first ? "" : ",") << endl << "    {\"name\": \"" << workload.name << "\"";
+        cout << std::left << std::setw(22) << workload.name << std::right;
+        for (const auto& [key, value] : metrics)
+        {
+            json << ", \"" << key << "\": " << std::setprecision(6) << value;
+            cout << std::setw(14) << std::setprecision(4) << value << " " << key;
+
+            // throughput should not drop and RSS should not grow
+            auto known = baseline.find(workload.name);
+            if (known != baseline.end() && known->second.contains(key) && known->second.at(key) > 0)
+            {
+                double change = 100.0 * (value / known->second.at(key) - 1);
+                cout << " (" << std::showpos << std::fixed << std::setprecision(1) << change << "%)" << std::noshowpos << std::defaultfloat;
+            }
+        }
+        json << "}";
+        cout << endl;
+        first = false;
+    }
+    json << endl << "  ]" << endl << "}" << endl;
+
+    if (not out_file.empty())
+    {
+        std::ofstream file(out_file, std::ofstream::trunc);
+        file << json.str();
+        if (not file)
+        {
+            cout << "ERROR: " << out_file << " could not be written!" << endl;
+            return 1;
+        }
+        cout << "results written to " << out_file << endl;
+    }
+    return all_finished ? 0 : 1;
+}
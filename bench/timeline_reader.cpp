@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "output.hpp"
+#include "timeline.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// reads a file written by --timeline-out=, only the blocks a query needs are decoded
+// usage: timeline_reader [--rows=FIRST:LAST] [--cycles=FIRST:LAST] [--program=<instruction_file>] [--summary] <timeline_file>
+// rows are printed tab separated with every stage, or as the simulator's cycle table when the program is given
+
+const string ROWS_FLAG = "--rows="; // rows FIRST up to but not including LAST, counting from 0
+const string CYCLES_FLAG = "--cycles="; // rows in the pipeline at some point from cycle FIRST to LAST
+const string PROGRAM_FLAG = "--program=";
+const string SUMMARY_FLAG = "--summary";
+
+const size_t FLUSH_SIZE = 1 << 20;
+
+// FIRST:LAST, either side may be left out to leave the range open
+static bool parse_range(const string& text, long long& first, long long& last)
+{
+    size_t colon = text.find(':');
+    if (colon == string::npos)
+    {
+        return false;
+    }
+    if (colon != 0)
+    {
+        first = std::stoll(text.substr(0, colon));
+    }
+    if (colon + 1 != text.length())
+    {
+        last = std::stoll(text.substr(colon + 1));
+    }
+    return true;
+}
+
+int main(const int argc, const char* argv[])
+{
+    long long first_row = 0;
+    long long last_row = LLONG_MAX;
+    long long first_cycle = 0;
+    long long last_cycle = LLONG_MAX;
+    string program_file;
+    bool summary = false;
+    vector<string> filenames;
+    for (int ii = 1; ii < argc; ii++)
+    {
+        string arg = argv[ii];
+        if (arg.starts_with(ROWS_FLAG))
+        {
+            if (not parse_range(arg.substr(ROWS_FLAG.length()), first_row, last_row))
+            {
+                cout << "ERROR: " << ROWS_FLAG << " needs FIRST:LAST" << endl;
+                return 1;
+            }
+        }
+        else if (arg.starts_with(CYCLES_FLAG))
+        {
+            if (not parse_range(arg.substr(CYCLES_FLAG.length()), first_cycle, last_cycle))
+            {
+                cout << "ERROR: " << CYCLES_FLAG << " needs FIRST:LAST" << endl;
+                return 1;
+            }
+        }
+        else if (arg.starts_with(PROGRAM_FLAG))
+        {
+            program_file = arg.substr(PROGRAM_FLAG.length());
+        }
+        else if (arg == SUMMARY_FLAG)
+        {
+            summary = true;
+        }
+        else
+        {
+            filenames.push_back(arg);
+        }
+    }
+    if (filenames.size() != 1)
+    {
+        cout << "ERROR: timeline_reader needs one timeline file!" << endl;
+        return 1;
+    }
+
+    TimelineFile timeline;
+    if (not open_timeline(timeline, filenames[0]))
+    {
+        return 1;
+    }
+    const PipelineConfig& config = *timeline.config;
+    const TimelineHeader& header = *timeline.header;
+
+    if (summary)
+    {
+        cout << "pipeline " << config.name << ", " << header.num_rows << " rows in " << header.num_blocks << " blocks, "
+             << timeline.mapped.size << " bytes";
+        if (header.num_rows != 0)
+        {
+            cout << " (" << (double)timeline.mapped.size / header.num_rows << " per row)";
+        }
+        cout << endl;
+        close_timeline(timeline);
+        return 0;
+    }
+
+    Program program;
+    string out;
+    if (program_file.empty())
+    {
+        out += "instruction\tline\tstalls";
+        for (Stage ii = 0; ii < config.num_stages; ii++)
+        {
+            out += '\t';
+            out += config.stage_names[ii];
+        }
+        out += '\n';
+    }
+    else
+    {
+        load_program(program, program_file);
+        format_output_header(out, config);
+    }
+
+    // skip straight to the first block either range can start in
+    uint64_t block = std::max(find_timeline_row(timeline, std::max(first_row, 0LL)), find_timeline_cycle(timeline, first_cycle));
+    vector<TimelineRow> rows;
+    Instruction instruction;
+    for (; block < header.num_blocks; block++)
+    {
+        const TimelineBlock& entry = timeline.blocks[block];
+        if ((long long)entry.first_row >= last_row || entry.first_cycle > last_cycle)
+        {
+            break;
+        }
+        if (not read_timeline_block(timeline, block, rows))
+        {
+            cout.write(out.data(), out.size());
+            cout << "ERROR: block " << block << " of " << filenames[0] << " is damaged!" << endl;
+            close_timeline(timeline);
+            return 1;
+        }
+
+        for (unsigned int ii = 0; ii < rows.size(); ii++)
+        {
+            const TimelineRow& row = rows[ii];
+            long long row_number = entry.first_row + ii;
+            long long last_finish = *std::max_element(row.finish_log, row.finish_log + config.num_stages);
+            if (row_number < first_row || row_number >= last_row || row.finish_log[IF] > last_cycle || last_finish < first_cycle)
+            {
+                continue;
+            }
+
+            if (program_file.empty())
+            {
+                out += std::to_string(row.instr_index);
+                out += '\t';
+                out += std::to_string(row.line_number);
+                out += '\t';
+                out += std::to_string(row.stalls);
+                for (Stage jj = 0; jj < config.num_stages; jj++)
+                {
+                    out += '\t';
+                    out += std::to_string(row.finish_log[jj]);
+                }
+                out += '\n';
+            }
+            else
+            {
+                instruction.line_number = row.line_number;
+                std::copy(row.finish_log, row.finish_log + MAX_STAGES, instruction.finish_log);
+                format_output_row(out, program, instruction, config);
+            }
+
+            if (out.size() >= FLUSH_SIZE)
+            {
+                cout.write(out.data(), out.size());
+                out.clear();
+            }
+        }
+    }
+    cout.write(out.data(), out.size());
+
+    close_timeline(timeline);
+    return 0;
+}
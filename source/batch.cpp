@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "batch.hpp"
+#include "functional.hpp"
+#include "memory.hpp"
+#include "utils.hpp"
+using std::bitset;
+using std::cout;
+using std::endl;
+using std::function;
+using std::ifstream;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+// tasks waiting to be run by one worker, other workers take from the back when stealing
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<int> tasks;
+};
+
+vector<BatchJob> read_manifest(const string& filename)
+{
+    vector<BatchJob> jobs;
+    ifstream file;
+    string line;
+
+    file.open(filename);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return jobs;
+    }
+
+    int line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        trim_line(line);
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        BatchJob job;
+        std::istringstream fields(line);
+        if (fields >> job.instruction_file >> job.data_file >> job.output_file)
+        {
+            jobs.push_back(job);
+        }
+        else
+        {
+            cout << "ERROR: manifest line " << line_number << " needs an instruction, data and output file!" << endl;
+        }
+    }
+
+    file.close();
+    return jobs;
+}
+
+// takes a task from the front of our own queue, or the back of someone else's
+bool take_task(vector<WorkQueue>& queues, const int self, int& task)
+{
+    int num_queues = queues.size();
+    for (int offset = 0; offset < num_queues; offset++)
+    {
+        WorkQueue& queue = queues[(self + offset) % num_queues];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        if (offset == 0)
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        else
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void run_tasks(const vector<function<void()>>& tasks, int num_threads)
+{
+    if (num_threads < 1)
+    {
+        num_threads = 1;
+    }
+
+    // deal the tasks out evenly, nothing is added once the workers start
+    vector<WorkQueue> queues = vector<WorkQueue>(num_threads);
+    for (unsigned int ii = 0; ii < tasks.size(); ii++)
+    {
+        queues[ii % num_threads].tasks.push_back(ii);
+    }
+
+    auto worker = [&](const int self) {
+        int task;
+        while (take_task(queues, self, task))
+        {
+            tasks[task]();
+        }
+    };
+
+    // the calling thread works too
+    vector<std::thread> threads;
+    for (int ii = 1; ii < num_threads; ii++)
+    {
+        threads.emplace_back(worker, ii);
+    }
+    worker(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void run_batch(const vector<BatchJob>& jobs, const Options& options, int num_threads)
+{
+    if (num_threads < 1)
+    {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto start_time = std::chrono::steady_clock::now();
+
+    // each file gets its slot before any worker starts, so workers never change the maps themselves
+    unordered_map<string, shared_ptr<Program>> programs;
+    unordered_map<string, vector<bitset<REG_SIZE>>> data_files;
+    for (const BatchJob& job : jobs)
+    {
+        if (not programs.contains(job.instruction_file))
+        {
+            programs[job.instruction_file] = std::make_shared<Program>();
+        }
+        data_files[job.data_file];
+    }
+
+    // parse every distinct file once
+    vector<function<void()>> load_tasks;
+    for (auto& [filename, program] : programs)
+    {
+        load_tasks.push_back([&filename, &program]() { load_program(*program, filename); });
+    }
+    for (auto& [filename, data] : data_files)
+    {
+        load_tasks.push_back([&filename, &data]() { load_data(data, filename); });
+    }
+    run_tasks(load_tasks, num_threads);
+
+    // printing from many threads at once would interleave the tables
+    Options job_options = options;
+    job_options.echo_output = false;
+
+    vector<function<void()>> job_tasks;
+    for (const BatchJob& job : jobs)
+    {
+        shared_ptr<const Program> program = programs.at(job.instruction_file);
+        const vector<bitset<REG_SIZE>>& data = data_files.at(job.data_file);
+
+        job_tasks.push_back([&job, program, &data, &job_options]() {
+            // every job gets its own copy of the data, the program is shared
+            Memory memory;
+            memory.program = program;
+            load_segment(memory.data, data);
+
+            if (job_options.functional_only)
+            {
+                run_functional(memory, job_options.use_jit);
+                write_state(memory, job.output_file);
+            }
+            else
+            {
+                run_program(memory, job_options, job.output_file);
+            }
+        });
+    }
+    run_tasks(job_tasks, num_threads);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    cout << "Ran " << jobs.size() << " jobs (" << programs.size() << " programs, " << data_files.size() << " data files) on "
+         << num_threads << " threads in " << elapsed.count() << "s" << endl;
+}
@@ -0,0 +1,26 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "options.hpp"
+
+// one simulation listed in a batch manifest
+struct BatchJob {
+    std::string instruction_file;
+    std::string data_file;
+    std::string output_file;
+};
+
+// reads "<instruction_file> <data_file> <output_file>" per line, blank lines and lines starting with "#" are skipped
+std::vector<BatchJob> read_manifest(const std::string& filename);
+
+// runs every job across num_threads workers (0 uses every core)
+// each instruction and data file is only parsed once, no matter how many jobs use it
+void run_batch(const std::vector<BatchJob>& jobs, const Options& options, int num_threads);
+
+// runs every task, each worker starts on its own share and steals from the others once it runs dry
+void run_tasks(const std::vector<std::function<void()>>& tasks, int num_threads);
+
+#endif
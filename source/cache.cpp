@@ -0,0 +1,145 @@
+#include <bit>
+#include <iomanip>
+#include <iostream>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "cache.hpp"
+using std::cout;
+using std::endl;
+
+bool valid_cache_config(const CacheConfig& config)
+{
+    if (config.line_size < 4 || not std::has_single_bit((unsigned int)config.line_size))
+    {
+        cout << "ERROR: the cache line size must be a power of two of at least 4 bytes!" << endl;
+        return false;
+    }
+    if (config.ways < 1 || config.ways > MAX_CACHE_WAYS)
+    {
+        cout << "ERROR: the cache must have between 1 and " << MAX_CACHE_WAYS << " ways!" << endl;
+        return false;
+    }
+    long long set_size = (long long)config.ways * config.line_size;
+    if (config.size <= 0 || config.size > MAX_CACHE_SIZE || config.size % set_size != 0 || not std::has_single_bit((unsigned long long)(config.size / set_size)))
+    {
+        cout << "ERROR: the cache size must be a power of two number of sets of " << config.ways << " ways of " << config.line_size << " bytes!" << endl;
+        return false;
+    }
+    if (config.hit_latency < 1 || config.miss_latency < 1)
+    {
+        cout << "ERROR: cache latencies must be at least 1 cycle!" << endl;
+        return false;
+    }
+    return true;
+}
+
+void start_cache(DataCache& cache, const CacheConfig& config)
+{
+    cache = DataCache();
+    cache.config = config;
+    cache.num_sets = config.size / (config.ways * config.line_size);
+    cache.line_bits = std::countr_zero((unsigned int)config.line_size);
+    cache.set_bits = std::countr_zero((unsigned int)cache.num_sets);
+    cache.stride = (config.ways + 3) & ~3;
+    cache.tags.assign((size_t)cache.num_sets * cache.stride, NO_TAG);
+    cache.stamps.assign((size_t)cache.num_sets * cache.stride, 0);
+}
+
+// index of the way holding tag in a set, -1 if none does
+// the padding past the real ways is NO_TAG, so it only ever matches when looking for an empty way
+static inline int find_way(const uint32_t* set_tags, const int stride, const uint32_t tag)
+{
+#if defined(__SSE2__)
+    __m128i wanted = _mm_set1_epi32(tag);
+    for (int ii = 0; ii < stride; ii += 4)
+    {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(set_tags + ii)), wanted);
+        int matches = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (matches)
+        {
+            return ii + std::countr_zero((unsigned int)matches);
+        }
+    }
+#else
+    for (int ii = 0; ii < stride; ii++)
+    {
+        if (set_tags[ii] == tag)
+        {
+            return ii;
+        }
+    }
+#endif
+    return -1;
+}
+
+// way a miss fills, an empty one if the set has any
+static int pick_victim(DataCache& cache, const uint32_t* set_tags, const uint64_t* set_stamps)
+{
+    int ways = cache.config.ways;
+    if (cache.config.policy == REPLACE_RANDOM)
+    {
+        int empty = find_way(set_tags, cache.stride, NO_TAG);
+        if (empty >= 0 && empty < ways)
+        {
+            return empty;
+        }
+        cache.random_state ^= cache.random_state << 13;
+        cache.random_state ^= cache.random_state >> 7;
+        cache.random_state ^= cache.random_state << 17;
+        return cache.random_state % ways;
+    }
+
+    // empty ways have stamp 0, older than anything filled
+    int victim = 0;
+    for (int ii = 1; ii < ways; ii++)
+    {
+        if (set_stamps[ii] < set_stamps[victim])
+        {
+            victim = ii;
+        }
+    }
+    return victim;
+}
+
+int cache_access(DataCache& cache, const uint32_t address, const bool is_store)
+{
+    uint32_t line = address >> cache.line_bits;
+    size_t set = line & (cache.num_sets - 1);
+    uint32_t tag = line >> cache.set_bits;
+    uint32_t* set_tags = &cache.tags[set * cache.stride];
+    uint64_t* set_stamps = &cache.stamps[set * cache.stride];
+    cache.clock++;
+
+    int way = find_way(set_tags, cache.stride, tag);
+    if (way >= 0)
+    {
+        (is_store ? cache.store_hits : cache.load_hits)++;
+        if (cache.config.policy == REPLACE_LRU)
+        {
+            set_stamps[way] = cache.clock;
+        }
+        return cache.config.hit_latency;
+    }
+
+    (is_store ? cache.store_misses : cache.load_misses)++;
+    way = pick_victim(cache, set_tags, set_stamps);
+    set_tags[way] = tag;
+    set_stamps[way] = cache.clock;
+    return cache.config.miss_latency;
+}
+
+void write_cache_report(std::ostream& out, const DataCache& cache)
+{
+    const CacheConfig& config = cache.config;
+    long long hits = cache.load_hits + cache.store_hits;
+    long long accesses = hits + cache.load_misses + cache.store_misses;
+
+    out << "Data cache: " << config.size << " bytes, " << config.ways << " ways, " << config.line_size << " byte lines, "
+        << REPLACEMENT_POLICY_NAMES[config.policy] << " replacement" << endl;
+    out << "Loads: " << cache.load_hits << " hits, " << cache.load_misses << " misses" << endl;
+    out << "Stores: " << cache.store_hits << " hits, " << cache.store_misses << " misses" << endl;
+    out << std::fixed << std::setprecision(2);
+    out << "Hit rate: " << (accesses == 0 ? 0.0 : 100.0 * hits / accesses) << "%" << endl;
+    out << std::defaultfloat << std::setprecision(6);
+}
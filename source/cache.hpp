@@ -0,0 +1,65 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+const int DEFAULT_CACHE_WAYS = 4;
+const int DEFAULT_CACHE_LINE_SIZE = 32;
+const int DEFAULT_CACHE_HIT_LATENCY = 1;
+const int DEFAULT_CACHE_MISS_LATENCY = 10;
+const int MAX_CACHE_WAYS = 32;
+const int MAX_CACHE_SIZE = 1 << 30;
+const uint32_t NO_TAG = UINT32_MAX; // never a real tag, every cache has at least a 4 byte line
+
+// which way of a full set a miss evicts
+enum ReplacementPolicy {REPLACE_LRU = 0, REPLACE_FIFO, REPLACE_RANDOM};
+const char* const REPLACEMENT_POLICY_NAMES[] = {"lru", "fifo", "random"};
+
+// shape and timing of the L1 data cache, a size of 0 models none and MEM takes its stage latency
+struct CacheConfig {
+    int size = 0; // bytes
+    int ways = DEFAULT_CACHE_WAYS;
+    int line_size = DEFAULT_CACHE_LINE_SIZE; // bytes
+    ReplacementPolicy policy = REPLACE_LRU;
+    int hit_latency = DEFAULT_CACHE_HIT_LATENCY; // cycles LW and SW spend in MEM on a hit
+    int miss_latency = DEFAULT_CACHE_MISS_LATENCY; // and on a miss
+
+    bool operator==(const CacheConfig& other) const = default;
+};
+
+// tags of every set, write allocate, only timing is modelled so lines hold no data
+struct DataCache {
+    CacheConfig config;
+    int line_bits = 0;
+    int set_bits = 0;
+    int num_sets = 0;
+    int stride = 0; // ways rounded up to a multiple of 4, so a set's tags can be compared 4 at a time
+
+    // set major, stride entries per set, the ones past config.ways stay NO_TAG
+    std::vector<uint32_t> tags;
+    std::vector<uint64_t> stamps; // LRU: last access, FIFO: fill, 0 for an empty way
+
+    uint64_t clock = 0; // accesses so far, stamps come from it
+    uint64_t random_state = 1; // xorshift state for REPLACE_RANDOM
+
+    long long load_hits = 0;
+    long long load_misses = 0;
+    long long store_hits = 0;
+    long long store_misses = 0;
+};
+
+// true if the sizes are powers of two that fit together, prints what is wrong otherwise
+bool valid_cache_config(const CacheConfig& config);
+
+// sizes an empty cache for a valid config
+void start_cache(DataCache& cache, const CacheConfig& config);
+
+// looks the line holding address up, filling it on a miss, and returns the cycles the access spends in MEM
+int cache_access(DataCache& cache, const uint32_t address, const bool is_store);
+
+// hit and miss counts of a run, written after its cycle table
+void write_cache_report(std::ostream& out, const DataCache& cache);
+
+#endif
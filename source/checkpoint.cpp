@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "checkpoint.hpp"
+#include "functional.hpp"
+#include "mapped_file.hpp"
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// the part of an instruction that came from its trace record, the rest is rebuilt by instruction_from_record()
+static TraceRecord record_from_instruction(const Instruction& instruction)
+{
+    TraceRecord record;
+    record.line_number = instruction.line_number;
+    record.address = instruction.address;
+    record.opcode = instruction.opcode;
+    record.result_reg = instruction.result_reg;
+    record.source_reg1 = instruction.source_reg1;
+    record.source_reg2 = instruction.source_reg2;
+    record.taken = instruction.branch_taken;
+    return record;
+}
+
+bool write_checkpoint(const string& filename, const Program& program, const PipelineConfig& config, const Pipeline& pipeline, const FlagReg& flags, const long long cycle, const TraceSource& source)
+{
+    if (not source.functional)
+    {
+        cout << "ERROR: checkpoints can only be taken of live runs, not of a replayed trace!" << endl;
+        return false;
+    }
+    const FunctionalState& functional = *source.functional;
+    const DataMemory& data = source.memory->data;
+
+    CheckpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.instruction_size = sizeof(CheckpointInstruction);
+    header.program_hash = hash_program(program);
+    strncpy(header.pipeline_name, config.name, sizeof(header.pipeline_name) - 1);
+    header.cycle = cycle;
+
+    header.num_fetched = pipeline.num_fetched;
+    header.num_retired = pipeline.num_retired;
+    header.num_changes = pipeline.num_changes;
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        header.last_writer[ii] = pipeline.last_writer[ii];
+        header.regs[ii] = functional.regs[ii];
+    }
+    header.pending_writes = pipeline.pending_writes;
+    header.flags = (flags.able_to_push ? CHECKPOINT_ABLE_TO_PUSH : 0) | (flags.finish_op_this_stage ? CHECKPOINT_FINISH_OP_THIS_STAGE : 0) | (flags.control_hazard_exists ? CHECKPOINT_CONTROL_HAZARD_EXISTS : 0) | (flags.able_to_insert ? CHECKPOINT_ABLE_TO_INSERT : 0) | (flags.finishing_up ? CHECKPOINT_FINISHING_UP : 0);
+    header.halted = functional.halted;
+    header.next_op = functional.next_op;
+    header.executed = functional.executed;
+
+    // every instruction that has not retired is sitting in a stage
+    vector<CheckpointInstruction> in_flight;
+    for (long long ii = pipeline.num_retired; ii < pipeline.num_fetched; ii++)
+    {
+        const Instruction& instruction = pipeline.window[ii % WINDOW_SIZE];
+        CheckpointInstruction packed;
+        packed.record = record_from_instruction(instruction);
+        for (Stage jj = 0; jj < MAX_STAGES; jj++)
+        {
+            packed.finish_log[jj] = instruction.finish_log[jj];
+        }
+        packed.stage_cycles = instruction.stage_cycles;
+        packed.mem_latency = instruction.mem_latency;
+        packed.in_stage = instruction.in_stage;
+        packed.progress = (instruction.already_wrote_result ? CHECKPOINT_WROTE_RESULT : 0) | (instruction.has_completed ? CHECKPOINT_COMPLETED : 0) | (instruction.predicted ? CHECKPOINT_PREDICTED : 0);
+        in_flight.push_back(packed);
+    }
+
+    // only the touched pages, an untouched one reads as 0 when it is loaded back
+    vector<uint32_t> page_numbers = resident_pages(data);
+    vector<uint32_t> words;
+    words.reserve(page_numbers.size() * WORDS_PER_PAGE);
+    for (uint32_t page_number : page_numbers)
+    {
+        for (int ii = 0; ii < WORDS_PER_PAGE; ii++)
+        {
+            words.push_back(peek_word(data, (page_number << PAGE_BITS) + ii * 4));
+        }
+    }
+
+    header.num_in_flight = in_flight.size();
+    header.num_records = source.num_buffered - source.next;
+    header.num_pages = page_numbers.size();
+    header.num_segment_words = data.num_segment_words;
+
+    if (pipeline.cache)
+    {
+        const DataCache& cache = *pipeline.cache;
+        header.cache_size = cache.config.size;
+        header.cache_ways = cache.config.ways;
+        header.cache_line_size = cache.config.line_size;
+        header.cache_policy = cache.config.policy;
+        header.cache_hit_latency = cache.config.hit_latency;
+        header.cache_miss_latency = cache.config.miss_latency;
+        header.cache_clock = cache.clock;
+        header.cache_random_state = cache.random_state;
+        header.cache_counts[0] = cache.load_hits;
+        header.cache_counts[1] = cache.load_misses;
+        header.cache_counts[2] = cache.store_hits;
+        header.cache_counts[3] = cache.store_misses;
+    }
+    if (pipeline.predictor)
+    {
+        header.predictor_kind = pipeline.predictor->config.kind;
+        header.btb_entries = pipeline.predictor->config.btb_entries;
+        header.predictor_history = pipeline.predictor->history;
+        header.num_branch_stats = pipeline.predictor->stats.size();
+    }
+
+    string temp_filename = filename + CHECKPOINT_TEMP_EXTENSION;
+    ofstream file;
+    file.open(temp_filename, ofstream::binary | ofstream::trunc);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)in_flight.data(), in_flight.size() * sizeof(CheckpointInstruction));
+    file.write((const char*)(source.buffer.data() + source.next), header.num_records * sizeof(TraceRecord));
+    file.write((const char*)page_numbers.data(), page_numbers.size() * sizeof(uint32_t));
+    file.write((const char*)words.data(), words.size() * sizeof(uint32_t));
+    if (pipeline.cache)
+    {
+        file.write((const char*)pipeline.cache->tags.data(), pipeline.cache->tags.size() * sizeof(uint32_t));
+        file.write((const char*)pipeline.cache->stamps.data(), pipeline.cache->stamps.size() * sizeof(uint64_t));
+    }
+    if (pipeline.predictor)
+    {
+        const BranchPredictor& predictor = *pipeline.predictor;
+        file.write((const char*)predictor.counters.data(), predictor.counters.size() * sizeof(uint8_t));
+        file.write((const char*)predictor.btb.data(), predictor.btb.size() * sizeof(int32_t));
+        file.write((const char*)predictor.stats.data(), predictor.stats.size() * sizeof(BranchStats));
+    }
+    file.close();
+
+    if (not file || std::rename(temp_filename.c_str(), filename.c_str()) != 0)
+    {
+        cout << "ERROR: checkpoint " << filename << " could not be written!" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const string& filename, const Program& program, const PipelineConfig& config, Pipeline& pipeline, FlagReg& flags, long long& cycle, TraceSource& source)
+{
+    if (not source.functional)
+    {
+        cout << "ERROR: checkpoints can only resume live runs, not a replayed trace!" << endl;
+        return false;
+    }
+
+    ifstream file;
+    file.open(filename, ifstream::binary);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    CheckpointHeader header;
+    file.read((char*)&header, sizeof(header));
+    bool valid = file && memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0 && header.version == CHECKPOINT_VERSION && header.instruction_size == sizeof(CheckpointInstruction);
+    valid = valid && header.num_in_flight <= WINDOW_SIZE && header.num_fetched - header.num_retired == (int64_t)header.num_in_flight && header.num_records <= source.buffer.size();
+    valid = valid && header.num_pages <= (uint64_t)NUM_PAGE_TABLES * PAGES_PER_TABLE;
+    if (not valid)
+    {
+        cout << "ERROR: " << filename << " is not a checkpoint written by this simulator!" << endl;
+        return false;
+    }
+    if (header.program_hash != hash_program(program) || strncmp(header.pipeline_name, config.name, sizeof(header.pipeline_name)) != 0)
+    {
+        cout << "ERROR: " << filename << " was taken of a different program or pipeline!" << endl;
+        return false;
+    }
+
+    CacheConfig cache_config;
+    cache_config.size = header.cache_size;
+    cache_config.ways = header.cache_ways;
+    cache_config.line_size = header.cache_line_size;
+    cache_config.policy = (ReplacementPolicy)header.cache_policy;
+    cache_config.hit_latency = header.cache_hit_latency;
+    cache_config.miss_latency = header.cache_miss_latency;
+    if ((header.cache_size != 0) != (pipeline.cache != nullptr) || (pipeline.cache && not (pipeline.cache->config == cache_config)))
+    {
+        cout << "ERROR: " << filename << " was taken with a different data cache!" << endl;
+        return false;
+    }
+    PredictorConfig predictor_config;
+    predictor_config.kind = (PredictorKind)header.predictor_kind;
+    predictor_config.btb_entries = header.btb_entries;
+    if ((header.predictor_kind != PREDICT_NONE) != (pipeline.predictor != nullptr) || (pipeline.predictor && not (pipeline.predictor->config == predictor_config && pipeline.predictor->stats.size() == header.num_branch_stats)))
+    {
+        cout << "ERROR: " << filename << " was taken with a different branch predictor!" << endl;
+        return false;
+    }
+
+    vector<CheckpointInstruction> in_flight = vector<CheckpointInstruction>(header.num_in_flight);
+    vector<uint32_t> page_numbers = vector<uint32_t>(header.num_pages);
+    vector<uint32_t> words = vector<uint32_t>(header.num_pages * WORDS_PER_PAGE);
+    file.read((char*)in_flight.data(), in_flight.size() * sizeof(CheckpointInstruction));
+    file.read((char*)source.buffer.data(), header.num_records * sizeof(TraceRecord));
+    file.read((char*)page_numbers.data(), page_numbers.size() * sizeof(uint32_t));
+    file.read((char*)words.data(), words.size() * sizeof(uint32_t));
+    vector<uint32_t> cache_tags;
+    vector<uint64_t> cache_stamps;
+    if (pipeline.cache)
+    {
+        cache_tags.resize(pipeline.cache->tags.size());
+        cache_stamps.resize(pipeline.cache->stamps.size());
+        file.read((char*)cache_tags.data(), cache_tags.size() * sizeof(uint32_t));
+        file.read((char*)cache_stamps.data(), cache_stamps.size() * sizeof(uint64_t));
+    }
+    vector<uint8_t> predictor_counters;
+    vector<int32_t> predictor_btb;
+    vector<BranchStats> branch_stats;
+    if (pipeline.predictor)
+    {
+        predictor_counters.resize(pipeline.predictor->counters.size());
+        predictor_btb.resize(pipeline.predictor->btb.size());
+        branch_stats.resize(pipeline.predictor->stats.size());
+        file.read((char*)predictor_counters.data(), predictor_counters.size() * sizeof(uint8_t));
+        file.read((char*)predictor_btb.data(), predictor_btb.size() * sizeof(int32_t));
+        file.read((char*)branch_stats.data(), branch_stats.size() * sizeof(BranchStats));
+    }
+    bool pages_valid = std::all_of(page_numbers.begin(), page_numbers.end(), [](const uint32_t page_number) { return page_number >> TABLE_BITS < (uint32_t)NUM_PAGE_TABLES; });
+
+    // every record becomes an instruction whose registers index the scoreboard, so they are checked like a trace's
+    int num_lines = program.instructions.size();
+    bool records_valid = std::all_of(in_flight.begin(), in_flight.end(), [num_lines](const CheckpointInstruction& packed) { return valid_record(packed.record, num_lines); })
+        && std::all_of(source.buffer.begin(), source.buffer.begin() + header.num_records, [num_lines](const TraceRecord& record) { return valid_record(record, num_lines); });
+    if (not file || not pages_valid || not records_valid || header.num_retired < 0 || header.next_op < 0 || header.next_op >= (int64_t)source.functional->ops.size())
+    {
+        cout << "ERROR: " << filename << " is not a checkpoint written by this simulator!" << endl;
+        return false;
+    }
+
+    // the cache and predictor belong to the run, only their contents come from the checkpoint
+    DataCache* cache = pipeline.cache;
+    BranchPredictor* predictor = pipeline.predictor;
+    pipeline = Pipeline();
+    pipeline.cache = cache;
+    pipeline.predictor = predictor;
+    if (predictor)
+    {
+        predictor->counters = predictor_counters;
+        predictor->btb = predictor_btb;
+        predictor->stats = branch_stats;
+        predictor->history = header.predictor_history;
+    }
+    if (cache)
+    {
+        cache->tags = cache_tags;
+        cache->stamps = cache_stamps;
+        cache->clock = header.cache_clock;
+        cache->random_state = header.cache_random_state;
+        cache->load_hits = header.cache_counts[0];
+        cache->load_misses = header.cache_counts[1];
+        cache->store_hits = header.cache_counts[2];
+        cache->store_misses = header.cache_counts[3];
+    }
+    pipeline.num_fetched = header.num_fetched;
+    pipeline.num_retired = header.num_retired;
+    pipeline.num_changes = header.num_changes;
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        pipeline.last_writer[ii] = header.last_writer[ii];
+    }
+    pipeline.pending_writes = header.pending_writes;
+
+    for (unsigned int ii = 0; ii < in_flight.size(); ii++)
+    {
+        const CheckpointInstruction& packed = in_flight[ii];
+        if (packed.in_stage < 0 || packed.in_stage >= config.num_stages || pipeline.active_instrs[packed.in_stage])
+        {
+            cout << "ERROR: " << filename << " has more than one instruction in a stage!" << endl;
+            return false;
+        }
+
+        long long instr_index = header.num_retired + ii;
+        Instruction& instruction = pipeline.window[instr_index % WINDOW_SIZE];
+        instruction = instruction_from_record(packed.record);
+        instruction.instr_index = instr_index;
+        for (Stage jj = 0; jj < MAX_STAGES; jj++)
+        {
+            instruction.finish_log[jj] = packed.finish_log[jj];
+        }
+        instruction.stage_cycles = packed.stage_cycles;
+        instruction.mem_latency = packed.mem_latency;
+        instruction.in_stage = packed.in_stage;
+        instruction.already_wrote_result = packed.progress & CHECKPOINT_WROTE_RESULT;
+        instruction.has_completed = packed.progress & CHECKPOINT_COMPLETED;
+        instruction.predicted = packed.progress & CHECKPOINT_PREDICTED;
+        pipeline.active_instrs[packed.in_stage] = &instruction;
+    }
+
+    flags = FlagReg();
+    flags.able_to_push = header.flags & CHECKPOINT_ABLE_TO_PUSH;
+    flags.finish_op_this_stage = header.flags & CHECKPOINT_FINISH_OP_THIS_STAGE;
+    flags.control_hazard_exists = header.flags & CHECKPOINT_CONTROL_HAZARD_EXISTS;
+    flags.able_to_insert = header.flags & CHECKPOINT_ABLE_TO_INSERT;
+    flags.finishing_up = header.flags & CHECKPOINT_FINISHING_UP;
+
+    // the functional engine carries on after the last record it handed over, its ops are already built
+    FunctionalState& functional = *source.functional;
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        functional.regs[ii] = header.regs[ii];
+    }
+    functional.next_op = header.next_op;
+    functional.executed = header.executed;
+    functional.halted = header.halted;
+    source.num_buffered = header.num_records;
+    source.next = 0;
+
+    DataMemory& data = source.memory->data;
+    clear_data(data);
+    for (unsigned int ii = 0; ii < page_numbers.size(); ii++)
+    {
+        uint32_t* page = touch_page(data, page_numbers[ii]);
+        std::copy(words.begin() + ii * WORDS_PER_PAGE, words.begin() + (ii + 1) * WORDS_PER_PAGE, page);
+    }
+    data.num_segment_words = header.num_segment_words;
+
+    cycle = header.cycle;
+    return true;
+}
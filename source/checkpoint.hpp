@@ -0,0 +1,97 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include "flag_reg.hpp"
+#include "memory.hpp"
+#include "pipeline.hpp"
+#include "program.hpp"
+#include "stage.hpp"
+#include "trace.hpp"
+
+const int CHECKPOINT_VERSION = 4;
+const char CHECKPOINT_MAGIC[8] = "MIPSCKP";
+const std::string CHECKPOINT_TEMP_EXTENSION = ".tmp"; // written first, then renamed over the last checkpoint
+
+// start of a checkpoint, every section follows in the order of the counts
+// in-flight instructions (oldest first), trace records the functional engine ran ahead with,
+// then the number of every touched data page followed by the words of each one,
+// then the data cache's tags and stamps if the run modelled one,
+// then the branch predictor's counters, BTB and per line stats if it had one
+struct CheckpointHeader {
+    char magic[8] = {};
+    uint32_t version = CHECKPOINT_VERSION;
+    uint32_t instruction_size = 0; // size of a CheckpointInstruction, catches checkpoints from a different layout
+    uint64_t program_hash = 0; // hash_program() of the program the checkpoint was taken of
+    char pipeline_name[8] = {}; // PipelineConfig::name, the window only makes sense for the same stages
+    int64_t cycle = 0; // next cycle to simulate
+
+    // pipeline
+    int64_t num_fetched = 0;
+    int64_t num_retired = 0;
+    int64_t num_changes = 0;
+    int64_t last_writer[NUM_REGS] = {};
+    uint32_t pending_writes = 0;
+    uint8_t flags = 0; // CHECKPOINT_* bits below
+    uint8_t halted = 0; // functional engine has run off the end or hit a HLT
+    uint8_t padding[2] = {};
+
+    // functional engine
+    uint32_t regs[NUM_REGS] = {};
+    int64_t next_op = 0;
+    int64_t executed = 0;
+
+    uint64_t num_in_flight = 0;
+    uint64_t num_records = 0;
+    uint64_t num_pages = 0;
+    uint64_t num_segment_words = 0; // DataMemory::num_segment_words
+
+    // data cache, a resumed run must model the same one, cache_size is 0 if there was none
+    int32_t cache_size = 0;
+    int32_t cache_ways = 0;
+    int32_t cache_line_size = 0;
+    int32_t cache_policy = 0;
+    int32_t cache_hit_latency = 0;
+    int32_t cache_miss_latency = 0;
+    uint64_t cache_clock = 0;
+    uint64_t cache_random_state = 0;
+    int64_t cache_counts[4] = {}; // load hits, load misses, store hits, store misses
+
+    // branch predictor, same rule as the cache, predictor_kind is PREDICT_NONE if there was none
+    int32_t predictor_kind = 0;
+    int32_t btb_entries = 0;
+    uint32_t predictor_history = 0;
+    uint32_t num_branch_stats = 0; // one per program line
+};
+
+const uint8_t CHECKPOINT_ABLE_TO_PUSH = 1;
+const uint8_t CHECKPOINT_FINISH_OP_THIS_STAGE = 2;
+const uint8_t CHECKPOINT_CONTROL_HAZARD_EXISTS = 4;
+const uint8_t CHECKPOINT_ABLE_TO_INSERT = 8;
+const uint8_t CHECKPOINT_FINISHING_UP = 16;
+
+// an instruction in flight, the record it was fetched from plus how far it has got
+struct CheckpointInstruction {
+    TraceRecord record;
+    int64_t finish_log[MAX_STAGES] = {};
+    int32_t stage_cycles = 0;
+    int32_t mem_latency = 0;
+    int8_t in_stage = IF;
+    uint8_t progress = 0; // CHECKPOINT_WROTE_RESULT, CHECKPOINT_COMPLETED and CHECKPOINT_PREDICTED
+    uint8_t padding[6] = {};
+};
+
+const uint8_t CHECKPOINT_WROTE_RESULT = 1;
+const uint8_t CHECKPOINT_COMPLETED = 2;
+const uint8_t CHECKPOINT_PREDICTED = 4;
+
+// saves everything a live run needs to carry on from cycle, source must be fed by the functional engine
+// the checkpoint is written next to filename first, so an interrupted write leaves the previous one intact
+bool write_checkpoint(const std::string& filename, const Program& program, const PipelineConfig& config, const Pipeline& pipeline, const FlagReg& flags, const long long cycle, const TraceSource& source);
+
+// puts a live run back into the state a checkpoint was taken in, cycle is set to the next one to simulate
+// the program and pipeline must be the ones it was taken of, the functional engine must already be started
+bool load_checkpoint(const std::string& filename, const Program& program, const PipelineConfig& config, Pipeline& pipeline, FlagReg& flags, long long& cycle, TraceSource& source);
+
+#endif
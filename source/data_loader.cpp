@@ -0,0 +1,241 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "data_loader.hpp"
+#include "mapped_file.hpp"
+#include "utils.hpp"
+using std::bitset;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+const int BINARY_WORD_CHARS = 32;
+const string RAW_WORDS_EXTENSION = ".bin";
+
+// fills data memory from input file
+// the file is mapped instead of read, and converted in a single pass
+void load_data(vector<bitset<REG_SIZE>>& data, const string& filename)
+{
+    MappedFile file = map_file(filename);
+    if (not file.is_open)
+    {
+        cout << "File could not be opened!" << endl;
+        return;
+    }
+
+    const char* begin = file.begin;
+    const char* end = file.begin + file.size;
+
+    data.clear();
+    switch (detect_data_format(filename, begin, end))
+    {
+    case BINARY_TEXT:
+        parse_binary_text(begin, end, data);
+        break;
+    case HEX_TEXT:
+        parse_hex_text(begin, end, data);
+        break;
+    case RAW_WORDS:
+        parse_raw_words(begin, end, data);
+        break;
+    };
+
+    unmap_file(file);
+}
+
+DataFormat detect_data_format(const string& filename, const char* begin, const char* end)
+{
+    if (filename.ends_with(RAW_WORDS_EXTENSION))
+    {
+        return RAW_WORDS;
+    }
+
+    // skip leading blank lines
+    const char* cur = begin;
+    while (cur < end && isspace((unsigned char)*cur))
+    {
+        cur++;
+    }
+
+    // a binary word is the only thing that can be 32 characters of "0"/"1"
+    int length = 0;
+    bool only_bits = true;
+    while (cur + length < end && not isspace((unsigned char)cur[length]))
+    {
+        only_bits = only_bits && (cur[length] == '0' || cur[length] == '1');
+        length++;
+    }
+
+    if (cur == end || (only_bits && length == BINARY_WORD_CHARS))
+    {
+        return BINARY_TEXT;
+    }
+    return HEX_TEXT;
+}
+
+// reverses the order of the bits in a word
+static inline uint32_t reverse_bits(uint32_t word)
+{
+    word = ((word >> 1) & 0x55555555) | ((word & 0x55555555) << 1);
+    word = ((word >> 2) & 0x33333333) | ((word & 0x33333333) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F) | ((word & 0x0F0F0F0F) << 4);
+    return __builtin_bswap32(word);
+}
+
+bool convert_binary_word(const char* chars, uint32_t& word)
+{
+#ifdef __SSE2__
+    // compare all 32 characters at once, each comparison gives one bit of the mask
+    __m128i low = _mm_loadu_si128((const __m128i*)chars);
+    __m128i high = _mm_loadu_si128((const __m128i*)(chars + 16));
+    __m128i ones = _mm_set1_epi8('1');
+    __m128i zeros = _mm_set1_epi8('0');
+
+    uint32_t is_one = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(low, ones)) | ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(high, ones)) << 16);
+    uint32_t is_zero = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(low, zeros)) | ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(high, zeros)) << 16);
+    if ((is_one | is_zero) != 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    // the first character is the most significant bit, but landed in bit 0 of the mask
+    word = reverse_bits(is_one);
+    return true;
+#else
+    word = 0;
+    for (int ii = 0; ii < BINARY_WORD_CHARS; ii++)
+    {
+        if (chars[ii] != '0' && chars[ii] != '1')
+        {
+            return false;
+        }
+        word = (word << 1) | (chars[ii] - '0');
+    }
+    return true;
+#endif
+}
+
+// reads a word the way "file >> bitset" would, for lines that are not exactly 32 bits
+static const char* parse_binary_word_slow(const char* cur, const char* line_end, uint32_t& word)
+{
+    while (cur < line_end && isspace((unsigned char)*cur))
+    {
+        cur++;
+    }
+
+    word = 0;
+    int num_bits = 0;
+    while (cur < line_end && num_bits < BINARY_WORD_CHARS && (*cur == '0' || *cur == '1'))
+    {
+        word = (word << 1) | (*cur - '0');
+        num_bits++;
+        cur++;
+    }
+    return cur;
+}
+
+// true if the line holds nothing but whitespace
+static bool blank_line(const char* cur, const char* line_end)
+{
+    while (cur < line_end)
+    {
+        if (not isspace((unsigned char)*cur))
+        {
+            return false;
+        }
+        cur++;
+    }
+    return true;
+}
+
+void parse_binary_text(const char* begin, const char* end, vector<bitset<REG_SIZE>>& data)
+{
+    // every line is 33 bytes in the usual case
+    data.reserve((end - begin) / (BINARY_WORD_CHARS + 1) + 1);
+
+    const char* cur = begin;
+    uint32_t word;
+    while (cur < end)
+    {
+        const char* line_end = (const char*)memchr(cur, '\n', end - cur);
+        if (not line_end)
+        {
+            line_end = end;
+        }
+
+        // fast path, exactly 32 bits followed by the end of the line
+        int length = line_end - cur;
+        if (length >= BINARY_WORD_CHARS && (length == BINARY_WORD_CHARS || (length == BINARY_WORD_CHARS + 1 && cur[BINARY_WORD_CHARS] == '\r')) && convert_binary_word(cur, word))
+        {
+            data.emplace_back(word);
+        }
+        else if (not blank_line(cur, line_end))
+        {
+            parse_binary_word_slow(cur, line_end, word);
+            data.emplace_back(word);
+        }
+
+        cur = line_end + 1;
+    }
+}
+
+void parse_hex_text(const char* begin, const char* end, vector<bitset<REG_SIZE>>& data)
+{
+    data.reserve((end - begin) / 9 + 1);
+
+    const char* cur = begin;
+    while (cur < end)
+    {
+        const char* line_end = (const char*)memchr(cur, '\n', end - cur);
+        if (not line_end)
+        {
+            line_end = end;
+        }
+
+        while (cur < line_end && isspace((unsigned char)*cur))
+        {
+            cur++;
+        }
+        if (cur == line_end)
+        {
+            cur = line_end + 1;
+            continue;
+        }
+
+        // optional "0x" prefix
+        if (line_end - cur >= 2 && cur[0] == '0' && (cur[1] == 'x' || cur[1] == 'X'))
+        {
+            cur += 2;
+        }
+
+        uint32_t word = 0;
+        while (cur < line_end && isxdigit((unsigned char)*cur))
+        {
+            char digit = *cur;
+            int value = (digit <= '9') ? digit - '0' : (digit | 0x20) - 'a' + 10;
+            word = (word << 4) | value;
+            cur++;
+        }
+        data.emplace_back(word);
+
+        cur = line_end + 1;
+    }
+}
+
+void parse_raw_words(const char* begin, const char* end, vector<bitset<REG_SIZE>>& data)
+{
+    size_t num_words = (end - begin) / sizeof(uint32_t);
+    data.resize(num_words);
+
+    for (size_t ii = 0; ii < num_words; ii++)
+    {
+        const unsigned char* bytes = (const unsigned char*)begin + ii * sizeof(uint32_t);
+        uint32_t word = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        data[ii] = word;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef DATA_LOADER_HPP
+#define DATA_LOADER_HPP
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "memory.hpp"
+
+// layouts a data file can be in
+// BINARY_TEXT is one 32 character word of "0"/"1" per line (the original format)
+// HEX_TEXT is one word of up to 8 hex digits per line, "0x" prefixes and "h" suffixes are allowed
+// RAW_WORDS is a headerless file of little-endian 32 bit words, picked by a ".bin" extension
+enum DataFormat {BINARY_TEXT = 0, HEX_TEXT = 1, RAW_WORDS = 2};
+
+// picks the format of a data file from its name and first line
+DataFormat detect_data_format(const std::string& filename, const char* begin, const char* end);
+
+// parsers for each format, they work straight on the mapped file and append one word per line
+void parse_binary_text(const char* begin, const char* end, std::vector<std::bitset<REG_SIZE>>& data);
+void parse_hex_text(const char* begin, const char* end, std::vector<std::bitset<REG_SIZE>>& data);
+void parse_raw_words(const char* begin, const char* end, std::vector<std::bitset<REG_SIZE>>& data);
+
+// converts exactly 32 "0"/"1" characters to a word, returns false if any other character shows up
+bool convert_binary_word(const char* chars, uint32_t& word);
+
+#endif
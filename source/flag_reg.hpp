@@ -7,18 +7,17 @@
 
 struct FlagReg {
 
-    // stage flags
-    bool has_structural_hazard = false;
-    bool has_data_hazard = false;
+    // stage flags, the decision made for the last stage that ran (frozen cycles reuse it, see ControlSnapshot)
     bool able_to_push = false;
     bool finish_op_this_stage = false;
-    bool is_stalling = false;
 
     // program flags
     bool control_hazard_exists = false;
     bool able_to_insert = true;
     bool finishing_up = false; // constant after set
     bool program_complete = false; // constant after set
+
+    bool operator==(const FlagReg& other) const = default;
 };
 
 #endif
@@ -0,0 +1,473 @@
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "functional.hpp"
+#include "utils.hpp"
+using std::vector;
+
+// picks the kind of op for a decoded instruction
+FunctionalKind functional_kind(const Instruction& instruction)
+{
+    bool register_form = instruction.source_reg2 != NO_REG;
+
+    switch (instruction.opcode)
+    {
+    case LW:
+        return F_LW;
+    case SW:
+        return F_SW;
+    case LI:
+        return F_LI;
+    case ADD:
+    case ADDI:
+        return register_form ? F_ADD : F_ADDI;
+    case MULT:
+    case MULTI:
+        return register_form ? F_MULT : F_MULTI;
+    case SUB:
+    case SUBI:
+        return register_form ? F_SUB : F_SUBI;
+    case BEQ:
+        return F_BEQ;
+    case BNE:
+        return F_BNE;
+    case J:
+        return F_J;
+    case HLT:
+        return F_HLT;
+    case NOP:
+        break;
+    };
+    return F_END;
+}
+
+vector<FunctionalOp> build_functional_ops(const Program& program)
+{
+    const vector<Instruction>& instructions = program.instructions;
+    int num_lines = instructions.size();
+
+    // index of the first op at or after each line, the same lines the pipeline would fetch
+    vector<int> next_op = vector<int>(num_lines + 1, 0);
+    int num_ops = 0;
+    for (int ii = 0; ii < num_lines; ii++)
+    {
+        if (instructions[ii].exists)
+        {
+            num_ops++;
+        }
+    }
+    next_op[num_lines] = num_ops;
+    for (int ii = num_lines - 1; ii >= 0; ii--)
+    {
+        next_op[ii] = instructions[ii].exists ? next_op[ii + 1] - 1 : next_op[ii + 1];
+    }
+
+    vector<FunctionalOp> ops;
+    ops.reserve(num_ops + 1);
+    for (int ii = 0; ii < num_lines; ii++)
+    {
+        const Instruction& instruction = instructions[ii];
+        if (not instruction.exists)
+        {
+            continue;
+        }
+
+        FunctionalOp op;
+        op.kind = functional_kind(instruction);
+        op.dispatch = op.kind;
+        op.line_number = instruction.line_number;
+        op.immediate = instruction.immediate;
+        op.rd = instruction.result_reg != NO_REG ? instruction.result_reg : 0;
+        op.rs = instruction.source_reg1 != NO_REG ? instruction.source_reg1 : 0;
+        op.rt = instruction.source_reg2 != NO_REG ? instruction.source_reg2 : 0;
+
+        // a target outside the program ends the run, like the pipeline running out of instructions
+        if (instruction.target >= 0 && instruction.target < num_lines)
+        {
+            op.target = next_op[instruction.target];
+        }
+        else
+        {
+            op.target = num_ops;
+        }
+        ops.push_back(op);
+    }
+
+    // sentinel for running off the end of the program
+    FunctionalOp end_op;
+    end_op.kind = F_END;
+    ops.push_back(end_op);
+
+    fuse_functional_ops(ops);
+    return ops;
+}
+
+// superinstruction for an LW followed by an arithmetic op reading the loaded register, F_END if there is none
+static FunctionalKind fused_load_kind(const FunctionalOp& load, const FunctionalOp& next)
+{
+    bool register_form = next.kind == F_ADD || next.kind == F_SUB;
+    bool dependent = next.rs == load.rd || (register_form && next.rt == load.rd);
+    if (not dependent)
+    {
+        return F_END;
+    }
+
+    switch (next.kind)
+    {
+    case F_ADD:
+        return F_LW_ADD;
+    case F_ADDI:
+        return F_LW_ADDI;
+    case F_SUB:
+        return F_LW_SUB;
+    case F_SUBI:
+        return F_LW_SUBI;
+    default:
+        return F_END;
+    }
+}
+
+void fuse_functional_ops(vector<FunctionalOp>& ops)
+{
+    // the sentinel is never the first of a pair, so ii + 1 is always in range
+    for (size_t ii = 0; ii + 1 < ops.size(); ii++)
+    {
+        const FunctionalOp& op = ops[ii];
+        const FunctionalOp& next = ops[ii + 1];
+
+        // loop counter step and the back edge it decides
+        if (op.kind == F_ADDI && next.kind == F_BNE)
+        {
+            ops[ii].dispatch = F_ADDI_BNE;
+        }
+        else if (op.kind == F_LW)
+        {
+            FunctionalKind fused = fused_load_kind(op, next);
+            if (fused != F_END)
+            {
+                ops[ii].dispatch = fused;
+            }
+        }
+    }
+}
+
+// fills a trace record from the static fields of an instruction and what it did when executed
+static inline void record_op(TraceRecord& record, const Instruction& instruction, const bool taken, const int address)
+{
+    record.line_number = instruction.line_number;
+    record.address = address;
+    record.opcode = instruction.opcode;
+    record.result_reg = instruction.result_reg;
+    record.source_reg1 = instruction.source_reg1;
+    record.source_reg2 = instruction.source_reg2;
+    record.taken = taken;
+}
+
+// the interpreter loop, instantiated for run_functional(), step_functional() and fast_forward_functional()
+// RECORD writes a trace record per instruction, LIMITED also stops after max_executed instructions
+template <bool RECORD, bool LIMITED>
+static long long execute_ops(FunctionalState& state, Memory& memory, TraceRecord* records, const long long max_executed)
+{
+    const vector<Instruction>& instructions = memory.program->instructions;
+    DataMemory& data = memory.data;
+    uint32_t* regs = state.regs;
+    const FunctionalOp* ops = state.ops.data();
+    const FunctionalOp* op = ops + state.next_op;
+    long long executed = 0;
+    long long num_records = 0;
+    int address;
+    bool taken;
+
+    // traced runs stay in the interpreter, the timing model needs a record of every instruction
+    JitCache* jit = RECORD ? nullptr : state.jit.get();
+    long long budget;
+
+    // one handler per FunctionalKind, in enum order
+    static const void* const HANDLERS[NUM_FUNCTIONAL_KINDS] = {
+        &&do_end, &&do_lw, &&do_sw, &&do_li,
+        &&do_add, &&do_addi, &&do_mult, &&do_multi, &&do_sub, &&do_subi,
+        &&do_beq, &&do_bne, &&do_j, &&do_hlt,
+        &&do_addi_bne, &&do_lw_add, &&do_lw_addi, &&do_lw_sub, &&do_lw_subi};
+
+#define DISPATCH()                           \
+    if constexpr (LIMITED)                   \
+    {                                        \
+        if (executed == max_executed)        \
+        {                                    \
+            goto reached_limit;              \
+        }                                    \
+    }                                        \
+    goto* HANDLERS[op->dispatch]
+
+// a superinstruction runs two ops, with only one left before the limit its first op runs alone
+#define DISPATCH_PAIR(FIRST)                 \
+    if constexpr (LIMITED)                   \
+    {                                        \
+        if (max_executed - executed < 2)     \
+        {                                    \
+            goto FIRST;                      \
+        }                                    \
+    }                                        \
+    executed += 2
+
+// a taken branch is where hot code is found, run it natively from here if it is compiled
+#define ENTER_BLOCK()                                                                                  \
+    if (jit)                                                                                           \
+    {                                                                                                  \
+        budget = LIMITED ? max_executed - executed : LLONG_MAX;                                        \
+        long long before = budget;                                                                     \
+        op = ops + enter_block(*jit, state.ops, op - ops, regs, &data, budget);                         \
+        executed += before - budget;                                                                   \
+    }
+
+#define RECORD_OP(TAKEN, ADDRESS)                                                                      \
+    if constexpr (RECORD)                                                                              \
+    {                                                                                                  \
+        record_op(records[num_records++], instructions[op->line_number - 1], TAKEN, ADDRESS);          \
+    }
+
+    DISPATCH();
+
+do_lw:    // {rd, #(rs)}
+    executed++;
+    address = regs[op->rs] + op->immediate;
+    regs[op->rd] = data_word(data, address);
+    RECORD_OP(false, address);
+    op++;
+    DISPATCH();
+
+do_sw:    // {rs, #(rt)}
+    executed++;
+    address = regs[op->rt] + op->immediate;
+    data_word(data, address) = regs[op->rs];
+    RECORD_OP(false, address);
+    op++;
+    DISPATCH();
+
+do_li:    // {rd, #}
+    executed++;
+    regs[op->rd] = op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_add:    // {rd, rs, rt}
+    executed++;
+    regs[op->rd] = regs[op->rs] + regs[op->rt];
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_addi:    // {rd, rs, #}
+    executed++;
+    regs[op->rd] = regs[op->rs] + (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_mult:    // {rd, rs, rt}
+    executed++;
+    regs[op->rd] = regs[op->rs] * regs[op->rt];
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_multi:    // {rd, rs, #}
+    executed++;
+    regs[op->rd] = regs[op->rs] * (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_sub:    // {rd, rs, rt}
+    executed++;
+    regs[op->rd] = regs[op->rs] - regs[op->rt];
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_subi:    // {rd, rs, #}
+    executed++;
+    regs[op->rd] = regs[op->rs] - (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_beq:    // {rs, rt, label/#}
+    executed++;
+    taken = regs[op->rs] == regs[op->rt];
+    RECORD_OP(taken, 0);
+    if (taken)
+    {
+        op = ops + op->target;
+        ENTER_BLOCK();
+    }
+    else
+    {
+        op++;
+    }
+    DISPATCH();
+
+do_bne:    // {rs, rt, label/#}
+    executed++;
+    taken = regs[op->rs] != regs[op->rt];
+    RECORD_OP(taken, 0);
+    if (taken)
+    {
+        op = ops + op->target;
+        ENTER_BLOCK();
+    }
+    else
+    {
+        op++;
+    }
+    DISPATCH();
+
+do_j:    // {label/#}
+    executed++;
+    RECORD_OP(true, 0);
+    op = ops + op->target;
+    ENTER_BLOCK();
+    DISPATCH();
+
+do_addi_bne:    // {rd, rs, #} then {rs, rt, label/#}
+    DISPATCH_PAIR(do_addi);
+    regs[op->rd] = regs[op->rs] + (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    taken = regs[op->rs] != regs[op->rt];
+    RECORD_OP(taken, 0);
+    if (taken)
+    {
+        op = ops + op->target;
+        ENTER_BLOCK();
+    }
+    else
+    {
+        op++;
+    }
+    DISPATCH();
+
+do_lw_add:    // {rd, #(rs)} then {rd, rs, rt}
+    DISPATCH_PAIR(do_lw);
+    address = regs[op->rs] + op->immediate;
+    regs[op->rd] = data_word(data, address);
+    RECORD_OP(false, address);
+    op++;
+    regs[op->rd] = regs[op->rs] + regs[op->rt];
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_lw_addi:    // {rd, #(rs)} then {rd, rs, #}
+    DISPATCH_PAIR(do_lw);
+    address = regs[op->rs] + op->immediate;
+    regs[op->rd] = data_word(data, address);
+    RECORD_OP(false, address);
+    op++;
+    regs[op->rd] = regs[op->rs] + (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_lw_sub:    // {rd, #(rs)} then {rd, rs, rt}
+    DISPATCH_PAIR(do_lw);
+    address = regs[op->rs] + op->immediate;
+    regs[op->rd] = data_word(data, address);
+    RECORD_OP(false, address);
+    op++;
+    regs[op->rd] = regs[op->rs] - regs[op->rt];
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_lw_subi:    // {rd, #(rs)} then {rd, rs, #}
+    DISPATCH_PAIR(do_lw);
+    address = regs[op->rs] + op->immediate;
+    regs[op->rd] = data_word(data, address);
+    RECORD_OP(false, address);
+    op++;
+    regs[op->rd] = regs[op->rs] - (uint32_t)op->immediate;
+    RECORD_OP(false, 0);
+    op++;
+    DISPATCH();
+
+do_hlt:    // {}
+    executed++;
+    RECORD_OP(false, 0);
+
+do_end:
+    state.halted = true;
+
+reached_limit: __attribute__((unused));
+#undef RECORD_OP
+#undef ENTER_BLOCK
+#undef DISPATCH_PAIR
+#undef DISPATCH
+
+    state.next_op = op - ops;
+    state.executed += executed;
+    return executed;
+}
+
+void start_functional(FunctionalState& state, const Memory& memory)
+{
+    state.ops = build_functional_ops(*memory.program);
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        state.regs[ii] = memory.registers[ii].to_ulong();
+    }
+    state.next_op = 0;
+    state.executed = 0;
+    state.halted = false;
+}
+
+int step_functional(FunctionalState& state, Memory& memory, TraceRecord* records, const int max_records)
+{
+    if (state.halted)
+    {
+        return 0;
+    }
+    return execute_ops<true, true>(state, memory, records, max_records);
+}
+
+long long fast_forward_functional(FunctionalState& state, Memory& memory, const long long num_instructions)
+{
+    if (state.halted)
+    {
+        return 0;
+    }
+    return execute_ops<false, true>(state, memory, nullptr, num_instructions);
+}
+
+void finish_functional(const FunctionalState& state, Memory& memory)
+{
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        memory.registers[ii] = state.regs[ii];
+    }
+}
+
+bool enable_jit(FunctionalState& state)
+{
+    state.jit = std::make_unique<JitCache>();
+    if (not start_jit(*state.jit, state.ops))
+    {
+        state.jit.reset();
+        return false;
+    }
+    return true;
+}
+
+long long run_functional(Memory& memory, const bool use_jit)
+{
+    FunctionalState state;
+    start_functional(state, memory);
+    if (use_jit)
+    {
+        enable_jit(state);
+    }
+    execute_ops<false, false>(state, memory, nullptr, 0);
+    finish_functional(state, memory);
+    return state.executed;
+}
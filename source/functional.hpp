@@ -0,0 +1,71 @@
+#ifndef FUNCTIONAL_HPP
+#define FUNCTIONAL_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "jit.hpp"
+#include "memory.hpp"
+#include "trace.hpp"
+
+// operation performed by a FunctionalOp, arithmetic is split by whether the last operand is a register
+// the kinds after F_HLT are superinstructions, they run an op and the one after it in a single dispatch
+enum FunctionalKind {F_END = 0, F_LW, F_SW, F_LI,
+                     F_ADD, F_ADDI, F_MULT, F_MULTI, F_SUB, F_SUBI,
+                     F_BEQ, F_BNE, F_J, F_HLT,
+                     F_ADDI_BNE, F_LW_ADD, F_LW_ADDI, F_LW_SUB, F_LW_SUBI};
+const int NUM_FUNCTIONAL_KINDS = F_LW_SUBI + 1;
+
+// compact form of a decoded instruction, blank lines are dropped and targets index straight into the ops
+struct FunctionalOp {
+    FunctionalKind kind = F_END; // what the instruction itself does, never a superinstruction
+    FunctionalKind dispatch = F_END; // handler the interpreter runs, kind or a superinstruction covering the next op too
+    int target = 0; // index of the op a taken branch or jump continues from
+    int rd = 0; // result register
+    int rs = 0; // first source register (base register for LW)
+    int rt = 0; // second source register (base register for SW)
+    int immediate = 0; // immediate operand or memory offset
+    int line_number = 0; // line the op was parsed from
+};
+
+// everything the functional engine needs to stop and pick up where it left off
+struct FunctionalState {
+    std::vector<FunctionalOp> ops;
+    uint32_t regs[NUM_REGS] = {};
+    int next_op = 0; // index of the next op to execute
+    long long executed = 0;
+    bool halted = false;
+    std::unique_ptr<JitCache> jit; // hot blocks translated to native code, nullptr interprets everything
+};
+
+// runs the program without modelling the pipeline, leaving the final state in memory
+// hot blocks are translated to native code if use_jit is set and the host is supported
+// returns the number of instructions executed
+long long run_functional(Memory& memory, const bool use_jit);
+
+// prepares a state to run the program in memory from its first instruction
+void start_functional(FunctionalState& state, const Memory& memory);
+
+// executes up to max_records instructions, writing a trace record for each
+// returns the number of records written, fewer than asked for only once the program halts
+int step_functional(FunctionalState& state, Memory& memory, TraceRecord* records, const int max_records);
+
+// lets fast_forward_functional() and run_functional() translate hot blocks, false if the host is not supported
+bool enable_jit(FunctionalState& state);
+
+// executes up to num_instructions instructions without recording them, returns the number executed
+// fewer than asked for only once the program halts
+long long fast_forward_functional(FunctionalState& state, Memory& memory, const long long num_instructions);
+
+// copies the register file from the functional state back into memory
+void finish_functional(const FunctionalState& state, Memory& memory);
+
+// builds the compact op list for a program, the last op is always an F_END sentinel
+// common pairs are already fused, see fuse_functional_ops()
+std::vector<FunctionalOp> build_functional_ops(const Program& program);
+
+// points dispatch at a superinstruction wherever an op and the one after it form a common pair
+// the second op keeps its own dispatch, so branching straight to it still runs it alone
+void fuse_functional_ops(std::vector<FunctionalOp>& ops);
+
+#endif
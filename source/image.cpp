@@ -0,0 +1,224 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "image.hpp"
+#include "mapped_file.hpp"
+#include "utils.hpp"
+using std::bitset;
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+bool write_image(const Program& program, const vector<bitset<REG_SIZE>>& data, const string& filename, const uint64_t program_hash, const uint64_t data_hash)
+{
+    ofstream file;
+    file.open(filename, ofstream::binary | ofstream::trunc);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    vector<ImageInstruction> instructions = vector<ImageInstruction>(program.instructions.size());
+    vector<ImageLabel> labels;
+    vector<uint64_t> line_offsets;
+    vector<uint32_t> words = vector<uint32_t>(data.size());
+    string text;
+
+    for (unsigned int ii = 0; ii < program.instructions.size(); ii++)
+    {
+        const Instruction& instruction = program.instructions[ii];
+        ImageInstruction& packed = instructions[ii];
+        packed.line_number = instruction.line_number;
+        packed.immediate = instruction.immediate;
+        packed.target = instruction.target;
+        packed.opcode = instruction.opcode;
+        packed.result_reg = instruction.result_reg;
+        packed.source_reg1 = instruction.source_reg1;
+        packed.source_reg2 = instruction.source_reg2;
+        packed.flags = (instruction.exists ? IMAGE_EXISTS : 0) | (instruction.writes_to_register ? IMAGE_WRITES_TO_REGISTER : 0) | (instruction.has_source_regs ? IMAGE_HAS_SOURCE_REGS : 0) | (instruction.is_branch ? IMAGE_IS_BRANCH : 0);
+    }
+
+    for (unsigned int ii = 0; ii < program.original_lines.size(); ii++)
+    {
+        line_offsets.push_back(text.size());
+        text += program.original_lines[ii];
+    }
+    line_offsets.push_back(text.size());
+
+    for (const auto& [name, line_number] : program.labels)
+    {
+        ImageLabel label;
+        label.name_offset = text.size();
+        label.name_length = name.size();
+        label.line_number = line_number;
+        labels.push_back(label);
+        text += name;
+    }
+
+    for (unsigned int ii = 0; ii < data.size(); ii++)
+    {
+        words[ii] = data[ii].to_ulong();
+    }
+
+    ImageHeader header;
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC));
+    header.instruction_size = sizeof(ImageInstruction);
+    header.program_hash = program_hash;
+    header.data_hash = data_hash;
+    header.num_instructions = instructions.size();
+    header.num_labels = labels.size();
+    header.num_words = words.size();
+    header.text_size = text.size();
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)instructions.data(), instructions.size() * sizeof(ImageInstruction));
+    file.write((const char*)labels.data(), labels.size() * sizeof(ImageLabel));
+    file.write((const char*)line_offsets.data(), line_offsets.size() * sizeof(uint64_t));
+    file.write((const char*)words.data(), words.size() * sizeof(uint32_t));
+    file.write(text.data(), text.size());
+    file.close();
+    return true;
+}
+
+static bool valid_register(const int reg)
+{
+    return reg >= NO_REG && reg < NUM_REGS;
+}
+
+// the simulator indexes by these fields without checking them, so a damaged image is rebuilt rather than loaded
+// line numbers count up from 1, a target can be past the end (a line number as a label) but BNE and J are at least -1
+static bool valid_sections(const ImageHeader& header, const ImageInstruction* instructions, const ImageLabel* labels, const uint64_t* line_offsets)
+{
+    for (uint64_t ii = 0; ii < header.num_instructions; ii++)
+    {
+        const ImageInstruction& packed = instructions[ii];
+        if (packed.line_number != (int64_t)ii + 1 || packed.opcode > HLT || packed.target < -1 || not valid_register(packed.result_reg)
+            || not valid_register(packed.source_reg1) || not valid_register(packed.source_reg2))
+        {
+            return false;
+        }
+    }
+    for (uint64_t ii = 0; ii < header.num_instructions; ii++)
+    {
+        if (line_offsets[ii] > line_offsets[ii + 1])
+        {
+            return false;
+        }
+    }
+    if (line_offsets[0] != 0 || line_offsets[header.num_instructions] > header.text_size)
+    {
+        return false;
+    }
+    for (uint64_t ii = 0; ii < header.num_labels; ii++)
+    {
+        const ImageLabel& label = labels[ii];
+        if (label.name_offset > header.text_size || label.name_length > header.text_size - label.name_offset
+            || label.line_number < 1 || (uint64_t)label.line_number > header.num_instructions)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool load_image(Program& program, vector<bitset<REG_SIZE>>& data, const string& filename, const uint64_t program_hash, const uint64_t data_hash)
+{
+    MappedFile file = map_file(filename);
+    if (not file.is_open || file.size < sizeof(ImageHeader))
+    {
+        unmap_file(file);
+        return false;
+    }
+
+    ImageHeader header;
+    memcpy(&header, file.begin, sizeof(header));
+    bool valid = memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) == 0 && header.version == IMAGE_VERSION && header.instruction_size == sizeof(ImageInstruction);
+    bool up_to_date = (program_hash == 0 || header.program_hash == program_hash) && (data_hash == 0 || header.data_hash == data_hash);
+
+    // every section has to fit inside the file, counts bigger than the file could hold would overflow the offsets
+    valid = valid && header.num_instructions < file.size / sizeof(ImageInstruction) && header.num_labels <= file.size / sizeof(ImageLabel)
+        && header.num_words <= file.size / sizeof(uint32_t) && header.text_size <= file.size;
+    uint64_t instructions_offset = sizeof(ImageHeader);
+    uint64_t labels_offset = instructions_offset + header.num_instructions * sizeof(ImageInstruction);
+    uint64_t line_offsets_offset = labels_offset + header.num_labels * sizeof(ImageLabel);
+    uint64_t words_offset = line_offsets_offset + (header.num_instructions + 1) * sizeof(uint64_t);
+    uint64_t text_offset = words_offset + header.num_words * sizeof(uint32_t);
+    if (not valid || not up_to_date || text_offset + header.text_size != file.size)
+    {
+        unmap_file(file);
+        return false;
+    }
+
+    const ImageInstruction* instructions = (const ImageInstruction*)(file.begin + instructions_offset);
+    const ImageLabel* labels = (const ImageLabel*)(file.begin + labels_offset);
+    const uint64_t* line_offsets = (const uint64_t*)(file.begin + line_offsets_offset);
+    const uint32_t* words = (const uint32_t*)(file.begin + words_offset);
+    const char* text = file.begin + text_offset;
+    if (not valid_sections(header, instructions, labels, line_offsets))
+    {
+        unmap_file(file);
+        return false;
+    }
+
+    program.instructions.assign(header.num_instructions, Instruction());
+    program.original_lines.resize(header.num_instructions);
+    for (uint64_t ii = 0; ii < header.num_instructions; ii++)
+    {
+        const ImageInstruction& packed = instructions[ii];
+        Instruction& instruction = program.instructions[ii];
+        instruction.line_number = packed.line_number;
+        instruction.immediate = packed.immediate;
+        instruction.target = packed.target;
+        instruction.opcode = (OPCODE)packed.opcode;
+        instruction.result_reg = packed.result_reg;
+        instruction.source_reg1 = packed.source_reg1;
+        instruction.source_reg2 = packed.source_reg2;
+        instruction.exists = packed.flags & IMAGE_EXISTS;
+        instruction.writes_to_register = packed.flags & IMAGE_WRITES_TO_REGISTER;
+        instruction.has_source_regs = packed.flags & IMAGE_HAS_SOURCE_REGS;
+        instruction.is_branch = packed.flags & IMAGE_IS_BRANCH;
+
+        program.original_lines[ii].assign(text + line_offsets[ii], line_offsets[ii + 1] - line_offsets[ii]);
+    }
+
+    program.labels.clear();
+    program.labels.reserve(header.num_labels);
+    for (uint64_t ii = 0; ii < header.num_labels; ii++)
+    {
+        program.labels.insert({string(text + labels[ii].name_offset, labels[ii].name_length), labels[ii].line_number});
+    }
+
+    data.resize(header.num_words);
+    for (uint64_t ii = 0; ii < header.num_words; ii++)
+    {
+        data[ii] = words[ii];
+    }
+
+    unmap_file(file);
+    return true;
+}
+
+void load_with_image_cache(Program& program, vector<bitset<REG_SIZE>>& data, const string& instruction_file, const string& data_file)
+{
+    string image_file = instruction_file + IMAGE_CACHE_EXTENSION;
+    uint64_t program_hash = hash_file(instruction_file);
+    uint64_t data_hash = hash_file(data_file);
+
+    // hashing is far cheaper than parsing, so a matching image skips parsing entirely
+    if (program_hash != 0 && data_hash != 0 && load_image(program, data, image_file, program_hash, data_hash))
+    {
+        return;
+    }
+
+    load_program(program, instruction_file);
+    load_data(data, data_file);
+    if (program_hash != 0 && data_hash != 0)
+    {
+        write_image(program, data, image_file, program_hash, data_hash);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "memory.hpp"
+#include "program.hpp"
+
+const int IMAGE_VERSION = 1;
+const char IMAGE_MAGIC[8] = "MIPSIMG";
+const std::string IMAGE_CACHE_EXTENSION = ".img"; // cached images sit next to their instruction file
+
+// start of a program image, every section follows in the order of the counts
+// instructions, labels, line offsets (num_instructions + 1), data words, then the text they all point into
+struct ImageHeader {
+    char magic[8] = {};
+    uint32_t version = IMAGE_VERSION;
+    uint32_t instruction_size = 0; // size of an ImageInstruction, catches images from a different layout
+    uint64_t program_hash = 0; // hash of the instruction file the image was built from
+    uint64_t data_hash = 0; // hash of the data file the image was built from
+    uint64_t num_instructions = 0;
+    uint64_t num_labels = 0;
+    uint64_t num_words = 0;
+    uint64_t text_size = 0;
+};
+
+// the parsed fields of an Instruction, packed to a fixed size
+struct ImageInstruction {
+    int32_t line_number = 0;
+    int32_t immediate = 0;
+    int32_t target = 0;
+    uint8_t opcode = NOP;
+    int8_t result_reg = NO_REG;
+    int8_t source_reg1 = NO_REG;
+    int8_t source_reg2 = NO_REG;
+    uint8_t flags = 0; // IMAGE_* bits below
+    uint8_t padding[7] = {};
+};
+
+const uint8_t IMAGE_EXISTS = 1;
+const uint8_t IMAGE_WRITES_TO_REGISTER = 2;
+const uint8_t IMAGE_HAS_SOURCE_REGS = 4;
+const uint8_t IMAGE_IS_BRANCH = 8;
+
+// a label, its name lives in the text section
+struct ImageLabel {
+    uint64_t name_offset = 0;
+    uint32_t name_length = 0;
+    int32_t line_number = 0;
+};
+
+// writes a program and its initial data segment as an image
+bool write_image(const Program& program, const std::vector<std::bitset<REG_SIZE>>& data, const std::string& filename, const uint64_t program_hash, const uint64_t data_hash);
+
+// fills a program and data segment from an image, the whole image is read through one mapping
+// if the hashes are not 0 they must match the ones the image was built with
+bool load_image(Program& program, std::vector<std::bitset<REG_SIZE>>& data, const std::string& filename, const uint64_t program_hash, const uint64_t data_hash);
+
+// loads from the cached image next to the instruction file if it was built from the same files
+// otherwise parses both files and refreshes the cache
+void load_with_image_cache(Program& program, std::vector<std::bitset<REG_SIZE>>& data, const std::string& instruction_file, const std::string& data_file);
+
+#endif
@@ -1,32 +1,51 @@
 #ifndef INSTRUCTION_HPP
 #define INSTRUCTION_HPP
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include "stage.hpp"
 
-enum OPCODE {LW = 1, SW = 2, LI = 3,
+enum OPCODE {NOP = 0, LW = 1, SW = 2, LI = 3,
              ADD = 4, ADDI = 5, MULT = 6, MULTI = 7, SUB = 8, SUBI = 9,
              BEQ = 10, BNE = 11, J = 12, HLT = 13};
 
+const int NO_REG = -1; // register index used when an operand slot is unused
+
+// bit for a register in a register mask, none for NO_REG
+inline uint32_t register_mask(const int reg)
+{
+    return reg == NO_REG ? 0 : 1u << reg;
+}
+
+// text fields of a single line, only kept around while the program is being parsed
+// they point into the cleaned up source text, so no line is ever copied apart from its original form
+struct InstructionText{
+    std::string_view label; // alphabetical tag used to refernce lines of code
+    std::string_view opcode; // name of operation
+    std::string_view arg1; // { X ,  ,  }
+    std::string_view arg2; // {  , X ,  }
+    std::string_view arg3; // {  ,  , X }
+};
+
 struct Instruction{
 
     // set when parsed, they do not change
     int line_number = 0; // line counting from 1
-    std::string original_line = ""; // original instruction like with minimal changes
-    std::string label = ""; // alphabetical tag used to refernce lines of code
-    std::string opcode = ""; // name of operation
-    std::string arg1 = ""; // { X ,  ,  }
-    std::string arg2 = ""; // {  , X ,  }
-    std::string arg3 = ""; // {  ,  , X }
-    std::string result_reg = ""; // location that result will be stored at
-    std::string source_reg1 = ""; // first dependency (may or may not be a raw argument)
-    std::string source_reg2 = ""; // second dependency (may or may not be a raw argument)
+    OPCODE opcode = NOP; // decoded operation
+    int result_reg = NO_REG; // index of register that result will be stored at
+    int source_reg1 = NO_REG; // index of first dependency (base register for LW)
+    int source_reg2 = NO_REG; // index of second dependency (base register for SW), NO_REG if operand is an immediate
+    int immediate = 0; // resolved immediate operand, or offset of a memory address
+    int target = 0; // PC to continue from when a branch is taken or a jump executes
 
     // used to execute
-    int instr_index = 0; // index of the instruction in the running_instr array
-    int nearest_data_hazard = 0; // set to index of instruction that must be waited on (in IF), increment by 1 when that instruction moves forward (when pushing)
-    int mem_count = 0;
-    bool has_data_hazard = false; // set to true if a data hazard is detected (in IF), set back to false when nearest data hazard has cleared (when pushing)
+    long long instr_index = 0; // order the instruction was fetched in, counting from 0
+    int stage_cycles = 0; // cycles spent in the current stage, checked against its latency
+    int mem_latency = 0; // cycles it spends in MEM, decided as it enters MEM (by the data cache for LW/SW)
+    int address = 0; // data address accessed by LW/SW (from its trace record)
+    bool branch_taken = false; // set if a branch was taken or a jump executed (from its trace record)
+    bool predicted = false; // set at fetch if the branch predictor got a branch or jump right, fetch does not wait on it
+    uint32_t source_mask = 0; // one bit per register read, checked against the pipeline's scoreboard
     bool has_source_regs = false; // set to false if opcode is LI or J or HLT (during parsing)
     bool writes_to_register = false; // set to false for control opcodes and HLT (during parsing)
     bool already_wrote_result = false; // set to true if/when the instruction has written their result (during execution)
@@ -34,7 +53,7 @@ struct Instruction{
     bool has_completed = false; // set to true when instruction has entered FINISHED, (after pushing)
     bool exists = false; // set to false when line is empty, or just missing an opcode
     Stage in_stage = IF;
-    int finish_log[NUM_STAGES];
+    long long finish_log[MAX_STAGES] = {};
 };
 
 #endif
@@ -0,0 +1,292 @@
+#include <cstddef>
+#include <cstring>
+#include <sys/mman.h>
+#include <type_traits>
+#include <vector>
+#include "jit.hpp"
+#include "functional.hpp"
+#include "memory.hpp"
+using std::vector;
+
+// LW and SW check the last page through fixed offsets into the DataMemory
+static_assert(std::is_standard_layout_v<DataMemory>, "the translator reads DataMemory fields by offset");
+static_assert(offsetof(DataMemory, last_page) == 0, "the translator loads last_page from [rsi]");
+
+// machine code of a block while it is being built, jumps are patched once their target is known
+struct CodeBuffer {
+    vector<uint8_t> bytes;
+
+    void emit(std::initializer_list<uint8_t> code) { bytes.insert(bytes.end(), code); }
+    void emit32(const int32_t value)
+    {
+        uint8_t little_endian[4];
+        memcpy(little_endian, &value, sizeof(value));
+        bytes.insert(bytes.end(), little_endian, little_endian + 4);
+    }
+
+    // emits a jump with a rel32 operand, returns where the operand is so patch_jump() can fill it in
+    size_t emit_jump(std::initializer_list<uint8_t> opcode)
+    {
+        emit(opcode);
+        emit32(0);
+        return bytes.size() - 4;
+    }
+    void patch_jump(const size_t operand, const size_t target)
+    {
+        int32_t offset = target - (operand + 4);
+        memcpy(&bytes[operand], &offset, sizeof(offset));
+    }
+};
+
+// registers while a block runs: rdi = regs, rsi = data memory, rdx = budget pointer, r8 = budget, eax/ecx/r9 = scratch
+// every register operand is [rdi + reg * 4] with a 32 bit displacement
+
+static void load_eax(CodeBuffer& code, const int reg)        // mov eax, [rdi + reg * 4]
+{
+    code.emit({0x8B, 0x87});
+    code.emit32(reg * 4);
+}
+
+static void store_eax(CodeBuffer& code, const int reg)       // mov [rdi + reg * 4], eax
+{
+    code.emit({0x89, 0x87});
+    code.emit32(reg * 4);
+}
+
+// the slow path of a load or store, walks the table so the address is on the last page afterwards
+static void touch_address(DataMemory* memory, const uint32_t address)
+{
+    touch_page(*memory, address >> PAGE_BITS);
+}
+
+// rax = byte offset of the word at regs[base] + offset within its page, once that page is the last page
+// the same lookup as data_word(), a miss saves the block's registers and calls touch_address()
+static void page_offset_rax(CodeBuffer& code, const int base, const int offset)
+{
+    load_eax(code, base);
+    code.emit({0x05});                      // add eax, offset
+    code.emit32(offset);
+    code.emit({0x89, 0xC1});                // mov ecx, eax
+    code.emit({0xC1, 0xE9, PAGE_BITS});     // shr ecx, PAGE_BITS
+    code.emit({0x3B, 0x8E});                // cmp ecx, [rsi + last_page_number]
+    code.emit32(offsetof(DataMemory, last_page_number));
+    size_t hit = code.emit_jump({0x0F, 0x84}); // je hit
+
+    // five pushes on top of the return address leave the stack 16 byte aligned for the call
+    code.emit({0x57, 0x56, 0x52, 0x41, 0x50, 0x50}); // push rdi, rsi, rdx, r8, rax
+    code.emit({0x48, 0x89, 0xF7});          // mov rdi, rsi
+    code.emit({0x89, 0xC6});                // mov esi, eax
+    code.emit({0x48, 0xB8});                // mov rax, touch_address
+    uint64_t function = (uint64_t)&touch_address;
+    for (int ii = 0; ii < 8; ii++)
+    {
+        code.bytes.push_back(function >> (ii * 8));
+    }
+    code.emit({0xFF, 0xD0});                // call rax
+    code.emit({0x58, 0x41, 0x58, 0x5A, 0x5E, 0x5F}); // pop rax, r8, rdx, rsi, rdi
+
+    code.patch_jump(hit, code.bytes.size());
+    code.emit({0x25});                      // and eax, PAGE_SIZE - 4
+    code.emit32(PAGE_SIZE - 4);
+}
+
+// straight line ops, false for the ones that end a block
+static bool emit_op(CodeBuffer& code, const FunctionalOp& op)
+{
+    switch (op.kind)
+    {
+    case F_LI:
+        code.emit({0xC7, 0x87});            // mov dword [rdi + rd * 4], immediate
+        code.emit32(op.rd * 4);
+        code.emit32(op.immediate);
+        return true;
+
+    case F_ADD:
+    case F_SUB:
+    case F_MULT:
+        load_eax(code, op.rs);
+        if (op.kind == F_ADD)
+        {
+            code.emit({0x03, 0x87});        // add eax, [rdi + rt * 4]
+        }
+        else if (op.kind == F_SUB)
+        {
+            code.emit({0x2B, 0x87});        // sub eax, [rdi + rt * 4]
+        }
+        else
+        {
+            code.emit({0x0F, 0xAF, 0x87});  // imul eax, [rdi + rt * 4]
+        }
+        code.emit32(op.rt * 4);
+        store_eax(code, op.rd);
+        return true;
+
+    case F_ADDI:
+    case F_SUBI:
+    case F_MULTI:
+        load_eax(code, op.rs);
+        if (op.kind == F_ADDI)
+        {
+            code.emit({0x05});              // add eax, immediate
+        }
+        else if (op.kind == F_SUBI)
+        {
+            code.emit({0x2D});              // sub eax, immediate
+        }
+        else
+        {
+            code.emit({0x69, 0xC0});        // imul eax, eax, immediate
+        }
+        code.emit32(op.immediate);
+        store_eax(code, op.rd);
+        return true;
+
+    case F_LW:
+        page_offset_rax(code, op.rs, op.immediate);
+        code.emit({0x4C, 0x8B, 0x0E});      // mov r9, [rsi + last_page]
+        code.emit({0x41, 0x8B, 0x04, 0x01}); // mov eax, [r9 + rax]
+        store_eax(code, op.rd);
+        return true;
+
+    case F_SW:
+        page_offset_rax(code, op.rt, op.immediate);
+        code.emit({0x4C, 0x8B, 0x0E});      // mov r9, [rsi + last_page]
+        code.emit({0x8B, 0x8F});            // mov ecx, [rdi + rs * 4]
+        code.emit32(op.rs * 4);
+        code.emit({0x41, 0x89, 0x0C, 0x01}); // mov [r9 + rax], ecx
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// leaves the block with next_op in eax, through the shared exit that writes the budget back
+static void emit_exit(CodeBuffer& code, const int next_op, vector<size_t>& exits)
+{
+    code.emit({0xB8});                      // mov eax, next_op
+    code.emit32(next_op);
+    exits.push_back(code.emit_jump({0xE9})); // jmp exit
+}
+
+// a taken branch to the block's own start loops inside it, as long as the budget covers another pass
+static void emit_taken(CodeBuffer& code, const int start, const int target, const int num_ops, const size_t loop_top, vector<size_t>& exits)
+{
+    if (target == start)
+    {
+        code.emit({0x49, 0x81, 0xF8});      // cmp r8, num_ops
+        code.emit32(num_ops);
+        code.patch_jump(code.emit_jump({0x0F, 0x8D}), loop_top); // jge loop_top
+    }
+    emit_exit(code, target, exits);
+}
+
+bool jit_supported()
+{
+#if defined(__x86_64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+JitCache::~JitCache()
+{
+    if (code)
+    {
+        munmap(code, JIT_CODE_SIZE);
+    }
+}
+
+bool start_jit(JitCache& cache, const vector<FunctionalOp>& ops)
+{
+    if (not jit_supported())
+    {
+        return false;
+    }
+
+    // only ever writable or executable, compile_block() flips it while copying a block in
+    void* memory = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    cache.code = (uint8_t*)memory;
+    cache.used = 0;
+    cache.blocks.assign(ops.size(), JitBlock());
+    cache.hits.assign(ops.size(), 0);
+    return true;
+}
+
+void compile_block(JitCache& cache, const vector<FunctionalOp>& ops, const int start)
+{
+    CodeBuffer code;
+    vector<size_t> exits;
+
+    code.emit({0x4C, 0x8B, 0x02});          // mov r8, [rdx]
+    size_t loop_top = code.bytes.size();
+
+    int num_ops = 0;
+    while (start + num_ops < (int)ops.size() && num_ops < JIT_MAX_BLOCK_OPS && emit_op(code, ops[start + num_ops]))
+    {
+        num_ops++;
+    }
+
+    // HLT and running off the end are left to the interpreter, branches and jumps end the block
+    const FunctionalOp& last = ops[start + num_ops];
+    bool ends_in_branch = num_ops < JIT_MAX_BLOCK_OPS && (last.kind == F_BEQ || last.kind == F_BNE || last.kind == F_J);
+    if (ends_in_branch)
+    {
+        num_ops++;
+    }
+    if (num_ops == 0)
+    {
+        return;
+    }
+
+    code.emit({0x49, 0x81, 0xE8});          // sub r8, num_ops
+    code.emit32(num_ops);
+
+    int fall_through = start + num_ops;
+    if (ends_in_branch && last.kind == F_J)
+    {
+        emit_taken(code, start, last.target, num_ops, loop_top, exits);
+    }
+    else if (ends_in_branch)
+    {
+        load_eax(code, last.rs);
+        code.emit({0x3B, 0x87});            // cmp eax, [rdi + rt * 4]
+        code.emit32(last.rt * 4);
+        size_t not_taken = last.kind == F_BEQ ? code.emit_jump({0x0F, 0x85}) : code.emit_jump({0x0F, 0x84}); // jne/je not_taken
+        emit_taken(code, start, last.target, num_ops, loop_top, exits);
+        code.patch_jump(not_taken, code.bytes.size());
+        emit_exit(code, fall_through, exits);
+    }
+    else
+    {
+        emit_exit(code, fall_through, exits);
+    }
+
+    for (size_t exit : exits)
+    {
+        code.patch_jump(exit, code.bytes.size());
+    }
+    code.emit({0x4C, 0x89, 0x02});          // mov [rdx], r8
+    code.emit({0xC3});                      // ret
+
+    if (cache.used + code.bytes.size() > JIT_CODE_SIZE)
+    {
+        return;
+    }
+    if (mprotect(cache.code, JIT_CODE_SIZE, PROT_READ | PROT_WRITE) != 0)
+    {
+        return;
+    }
+    memcpy(cache.code + cache.used, code.bytes.data(), code.bytes.size());
+    mprotect(cache.code, JIT_CODE_SIZE, PROT_READ | PROT_EXEC);
+
+    JitBlock& block = cache.blocks[start];
+    block.code = (JitFunction)(cache.code + cache.used);
+    block.num_ops = num_ops;
+    cache.used += code.bytes.size();
+}
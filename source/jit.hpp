@@ -0,0 +1,68 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct DataMemory;
+struct FunctionalOp;
+
+const int JIT_HOT_THRESHOLD = 50; // taken branches to a block before it is compiled
+const int JIT_MAX_BLOCK_OPS = 64; // longer straight line code is split into several blocks
+const size_t JIT_CODE_SIZE = 1 << 20; // bytes of executable memory, once full everything else stays interpreted
+
+// native code of one block, reads and writes the register file and data memory in place
+// loads and stores hit the last page inline and call out to walk the page table when they miss
+// budget is how many instructions it may still execute, it is lowered by every instruction that ran
+// a block that branches back to its own start keeps looping while the budget allows another pass
+// returns the index of the op to continue from
+typedef int (*JitFunction)(uint32_t* regs, DataMemory* data, long long* budget);
+
+// a run of ops from a branch target up to and including the next branch or jump
+struct JitBlock {
+    JitFunction code = nullptr; // nullptr until compiled
+    int num_ops = 0;
+};
+
+// translated blocks of one program, indexed by the op each one starts at
+// only the functional engine's untraced runs use it, the timing model needs every instruction's record
+struct JitCache {
+    uint8_t* code = nullptr; // executable memory holding every compiled block
+    size_t used = 0;
+    std::vector<JitBlock> blocks;
+    std::vector<int> hits; // taken branches to each op so far
+
+    ~JitCache();
+};
+
+// true on hosts the translator emits code for (x86-64)
+bool jit_supported();
+
+// maps the code memory and sizes the tables for the ops, false if the host is not supported
+bool start_jit(JitCache& cache, const std::vector<FunctionalOp>& ops);
+
+// translates the block starting at op start, it stays interpreted if it has nothing to translate or the cache is full
+void compile_block(JitCache& cache, const std::vector<FunctionalOp>& ops, const int start);
+
+// called for every taken branch, runs native code from start for as long as the blocks reached are compiled
+// a block that is not compiled yet gets a hit and is compiled once it is hot
+// returns the op the interpreter continues from, start itself if nothing ran
+inline int enter_block(JitCache& cache, const std::vector<FunctionalOp>& ops, const int start, uint32_t* regs, DataMemory* data, long long& budget)
+{
+    JitBlock* block = &cache.blocks[start];
+    if (not block->code && ++cache.hits[start] == JIT_HOT_THRESHOLD)
+    {
+        compile_block(cache, ops, start);
+    }
+
+    int next = start;
+    while (block->code && budget >= block->num_ops)
+    {
+        next = block->code(regs, data, &budget);
+        block = &cache.blocks[next];
+    }
+    return next;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::string;
+using std::string_view;
+using std::vector;
+
+// same characters as WHITESPACE in utils.cpp
+static inline bool is_whitespace(const char ch)
+{
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+// fills instruction memory from input file, "-" reads from stdin
+void load_program(Program& program, const string& filename)
+{
+    if (filename == STDIN_FILENAME)
+    {
+        load_program(program, std::cin);
+        return;
+    }
+
+    ifstream file;
+    file.open(filename, ifstream::binary);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return;
+    }
+    load_program(program, file);
+}
+
+// fills instruction memory from any stream, read once from start to end
+void load_program(Program& program, std::istream& in)
+{
+    string source = read_stream(in);
+    vector<InstructionText> texts = lex_program(program, source);
+
+    fill_label_map(program, texts);
+
+    // resolve operands now that every label is known
+    for (unsigned int ii = 0; ii < program.instructions.size(); ii++)
+    {
+        decode_instruction(program.instructions[ii], texts[ii], program.labels);
+    }
+}
+
+string read_stream(std::istream& in)
+{
+    string source;
+    size_t length = 0;
+    do
+    {
+        source.resize(length + READ_CHUNK_SIZE);
+        in.read(source.data() + length, READ_CHUNK_SIZE);
+        length += in.gcount();
+    } while (in);
+    source.resize(length);
+    return source;
+}
+
+vector<InstructionText> lex_program(Program& program, string& source)
+{
+    // every "\n" ends a line, and whatever follows the last one is a line too (even if empty)
+    size_t num_lines = std::count(source.begin(), source.end(), '\n') + 1;
+    program.instructions.assign(num_lines, Instruction());
+    program.original_lines.assign(num_lines, string());
+    vector<InstructionText> texts = vector<InstructionText>(num_lines);
+
+    char* line = source.data();
+    char* end = source.data() + source.size();
+    for (size_t ii = 0; ii < num_lines; ii++)
+    {
+        char* newline = (char*)memchr(line, '\n', end - line);
+        newline = newline ? newline : end;
+        Instruction& instruction = program.instructions[ii];
+        instruction.line_number = ii + 1;
+
+        size_t length = clean_line(line, newline - line, program.original_lines[ii]);
+        lex_line(instruction, texts[ii], string_view(line, length));
+        line = newline + (newline != end);
+    }
+    return texts;
+}
+
+size_t clean_line(char* line, const size_t length, string& original_line)
+{
+    // drop bars while shifting the rest of the line down
+    size_t new_length = 0;
+    for (size_t ii = 0; ii < length; ii++)
+    {
+        char ch = line[ii];
+        if (ch == '|')
+        {
+            continue;
+        }
+        line[new_length++] = ch == '\r' ? ' ' : ch;
+    }
+    original_line.assign(line, new_length);
+
+    // the rest of parsing is case insensitive
+    for (size_t ii = 0; ii < new_length; ii++)
+    {
+        if (line[ii] >= 'a' && line[ii] <= 'z')
+        {
+            line[ii] -= 'a' - 'A';
+        }
+    }
+    return new_length;
+}
+
+void lex_line(Instruction& instruction, InstructionText& text, string_view line)
+{
+    line = trim(line);
+
+    // label comes before a ":"
+    size_t colon_pos = line.find(':');
+    if (colon_pos != string_view::npos)
+    {
+        text.label = trim(line.substr(0, colon_pos));
+        line = trim(line.substr(colon_pos + 1));
+    }
+
+    // line is blank or only a label
+    if (line.empty())
+    {
+        instruction.exists = false;
+        return;
+    }
+    instruction.exists = true;
+
+    // opcode does not need a space after it, so take the longest one the line starts with
+    size_t opcode_length = match_opcode(line, instruction.opcode);
+    if (opcode_length == 0)
+    {    // left for decode_instruction() to report
+        text.opcode = line;
+        line = string_view();
+    }
+    else
+    {
+        text.opcode = line.substr(0, opcode_length);
+        line = line.substr(opcode_length);
+    }
+
+    text.arg1 = next_argument(line);
+    text.arg2 = next_argument(line);
+    text.arg3 = next_argument(line);
+}
+
+size_t match_opcode(string_view line, OPCODE& opcode)
+{
+    for (const auto& [name, named_opcode] : OPCODE_NAMES)
+    {
+        if (line.starts_with(name))
+        {
+            opcode = named_opcode;
+            return name.length();
+        }
+    }
+    return 0;
+}
+
+string_view next_argument(string_view& line)
+{
+    line = trim(line);
+
+    string_view next_arg;
+    size_t comma_pos = line.find(',');
+    if (comma_pos != string_view::npos)
+    {    // comma exists (at least 2 arguments left)
+        next_arg = line.substr(0, comma_pos);
+        line = line.substr(comma_pos + 1);
+    }
+    else
+    {    // comma does not exist (only 1 argument left)
+        next_arg = line;
+        line = string_view();
+    }
+    return trim(next_arg);
+}
+
+string_view trim(string_view str)
+{
+    size_t first = 0;
+    size_t last = str.length();
+    while (first < last && is_whitespace(str[first]))
+    {
+        first++;
+    }
+    while (last > first && is_whitespace(str[last - 1]))
+    {
+        last--;
+    }
+    return str.substr(first, last - first);
+}
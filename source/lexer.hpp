@@ -0,0 +1,37 @@
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "instruction.hpp"
+#include "program.hpp"
+
+const std::string STDIN_FILENAME = "-"; // reads the program from standard input instead of a file
+const int READ_CHUNK_SIZE = 1 << 20; // bytes pulled from the input stream at a time
+
+// reads a whole stream, it is never seeked so pipes and stdin work
+std::string read_stream(std::istream& in);
+
+// splits source into lines and lexes each one into the program's instructions and original lines
+// source is cleaned up in place, the returned texts point into it and are only valid as long as it is
+std::vector<InstructionText> lex_program(Program& program, std::string& source);
+
+// removes "|", turns "\r" into a space and uppercases a line in place, returns its new length
+// the original line is copied out before uppercasing, since output rows show it as written
+size_t clean_line(char* line, const size_t length, std::string& original_line);
+
+// splits a cleaned up line into label, opcode and operands, also sets the opcode and exists flag of the instruction
+void lex_line(Instruction& instruction, InstructionText& text, std::string_view line);
+
+// returns the length of the longest opcode the line starts with, 0 if there is none
+size_t match_opcode(std::string_view line, OPCODE& opcode);
+
+// splits off the next comma seperated operand, empty once every operand has been taken
+std::string_view next_argument(std::string_view& line);
+
+// removes leading and trailing whitespace without copying
+std::string_view trim(std::string_view str);
+
+#endif
@@ -1,27 +1,285 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "memory.hpp"
 #include "utils.hpp"
+#include "functional.hpp"
+#include "options.hpp"
+#include "batch.hpp"
+#include "image.hpp"
+#include "mapped_file.hpp"
+#include "sampling.hpp"
+using std::cout;
+using std::endl;
 using std::string;
-
-extern const bool ENABLE_UNLIMITED_INPUT = false; // true enables variable sized input
-extern const int OPTIONAL_CYCLE_LIMIT = 100; // custom cycle limit
-extern const int MAX_CYCLE_LIMIT = 1000; // amount of instruction memory given to program
+using std::vector;
 
 const string DEFAULT_INST_FILE = "default_inst.txt";
 const string DEFAULT_DATA_FILE = "default_data_segment.txt";
 const string DEFAULT_OUTPUT_FILE = "default_output.txt";
 const string CUSTOM_INST_FILE = "custom_inst.txt";
-const int EXPECTED_NUM_ARGS = 4;
+const unsigned int EXPECTED_NUM_FILES = 3;
+
+// skips the pipeline and only writes the final registers and data
+const string FUNCTIONAL_FLAG = "--functional";
+
+// writes the trace of executed instructions to a file instead of timing them
+const string TRACE_OUT_FLAG = "--trace-out=";
+
+// times a previously written trace, the instruction file is only used for the text of each row
+const string TRACE_IN_FLAG = "--trace-in=";
+
+// stops the pipeline after this many cycles, 0 runs until the program finishes
+const string CYCLE_LIMIT_FLAG = "--cycle-limit=";
+
+// only writes the output file, nothing is echoed to the console
+const string QUIET_FLAG = "--quiet";
+
+// runs every job listed in a manifest file on a pool of threads
+const string BATCH_FLAG = "--batch=";
+
+// number of threads used by a batch, every core by default
+const string THREADS_FLAG = "--threads=";
+
+// shape of the pipeline to time, one of the names in COMPILED_PIPELINES (5, 7 or 9 stages)
+const string PIPELINE_FLAG = "--pipeline=";
+
+// steps the pipeline through every cycle instead of jumping over ones where nothing changes
+const string EVERY_CYCLE_FLAG = "--every-cycle";
+
+// loads the program and data from a precompiled image instead of parsing them
+const string IMAGE_IN_FLAG = "--image-in=";
+
+// writes the parsed program and data to an image that --image-in can load
+const string IMAGE_OUT_FLAG = "--image-out=";
+
+// keeps an image next to the instruction file and only reparses when either input file changes
+const string IMAGE_CACHE_FLAG = "--image-cache";
+
+// resumes a run from a checkpoint written by --checkpoint-out, the instruction file must be the same
+const string CHECKPOINT_IN_FLAG = "--checkpoint-in=";
+
+// saves the run to a checkpoint when it stops, or every --checkpoint-every cycles
+const string CHECKPOINT_OUT_FLAG = "--checkpoint-out=";
+const string CHECKPOINT_EVERY_FLAG = "--checkpoint-every=";
+
+// estimates the timing of a long program from a window of the pipeline every N instructions
+// only the windows are timed, the instructions between them are executed functionally
+const string SAMPLE_EVERY_FLAG = "--sample-every=";
+const string SAMPLE_WARMUP_FLAG = "--sample-warmup=";
+const string SAMPLE_WINDOW_FLAG = "--sample-window=";
+
+// keeps functional runs in the interpreter instead of translating hot blocks to native code
+const string INTERPRET_FLAG = "--interpret";
+
+// models an L1 data cache behind LW and SW, their time in MEM then depends on whether they hit
+// the cache is only modelled once --cache-size= is given, the rest default to cache.hpp's values
+const string CACHE_SIZE_FLAG = "--cache-size=";
+const string CACHE_WAYS_FLAG = "--cache-ways=";
+const string CACHE_LINE_FLAG = "--cache-line=";
+const string CACHE_POLICY_FLAG = "--cache-policy=";
+const string CACHE_HIT_FLAG = "--cache-hit=";
+const string CACHE_MISS_FLAG = "--cache-miss=";
+
+// lets fetch carry on past branches with one of PREDICTOR_NAMES, mispredicted ones still wait to resolve
+const string PREDICTOR_FLAG = "--predictor=";
+const string BTB_ENTRIES_FLAG = "--btb-entries=";
+
+// counts the cycles each stage and line loses to each kind of hazard, written as CSV if the file ends in .csv, JSON otherwise
+const string STATS_OUT_FLAG = "--stats-out=";
+
+// writes every instruction's finish cycle in every stage to a compact binary file, read back with bin/timeline_reader
+const string TIMELINE_OUT_FLAG = "--timeline-out=";
+
+// logs which instruction is in which stage every cycle, and which are stalled, in the Kanata format Konata loads
+const string OCCUPANCY_OUT_FLAG = "--occupancy-out=";
 
 int main(const int argc, const char* argv[]){
 
     string instruction_file;
     string data_file;
     string output_file;
+    string trace_out_file;
+    string trace_in_file;
+    string batch_file;
+    string image_in_file;
+    string image_out_file;
+    bool use_image_cache = false;
+    int num_threads = 0;
+    Options options;
+
+    // seperate flags from filenames, flags can appear anywhere
+    vector<string> filenames;
+    for (int ii = 1; ii < argc; ii++){
+        string arg = argv[ii];
+        if (arg == FUNCTIONAL_FLAG){
+            options.functional_only = true;
+        }
+        else if (arg.starts_with(TRACE_OUT_FLAG)){
+            trace_out_file = arg.substr(TRACE_OUT_FLAG.length());
+        }
+        else if (arg.starts_with(TRACE_IN_FLAG)){
+            trace_in_file = arg.substr(TRACE_IN_FLAG.length());
+        }
+        else if (arg.starts_with(CYCLE_LIMIT_FLAG)){
+            options.cycle_limit = stoll(arg.substr(CYCLE_LIMIT_FLAG.length()));
+        }
+        else if (arg == QUIET_FLAG){
+            options.echo_output = false;
+        }
+        else if (arg.starts_with(BATCH_FLAG)){
+            batch_file = arg.substr(BATCH_FLAG.length());
+        }
+        else if (arg.starts_with(THREADS_FLAG)){
+            num_threads = stoi(arg.substr(THREADS_FLAG.length()));
+        }
+        else if (arg.starts_with(PIPELINE_FLAG)){
+            options.pipeline = find_pipeline_config(arg.substr(PIPELINE_FLAG.length()));
+            if (not options.pipeline){
+                cout << "ERROR: unknown pipeline \"" << arg.substr(PIPELINE_FLAG.length()) << "\"!" << endl;
+                return 1;
+            }
+        }
+        else if (arg == INTERPRET_FLAG){
+            options.use_jit = false;
+        }
+        else if (arg == EVERY_CYCLE_FLAG){
+            options.skip_quiet_cycles = false;
+        }
+        else if (arg.starts_with(IMAGE_IN_FLAG)){
+            image_in_file = arg.substr(IMAGE_IN_FLAG.length());
+        }
+        else if (arg.starts_with(IMAGE_OUT_FLAG)){
+            image_out_file = arg.substr(IMAGE_OUT_FLAG.length());
+        }
+        else if (arg == IMAGE_CACHE_FLAG){
+            use_image_cache = true;
+        }
+        else if (arg.starts_with(CHECKPOINT_IN_FLAG)){
+            options.checkpoint_in_file = arg.substr(CHECKPOINT_IN_FLAG.length());
+        }
+        else if (arg.starts_with(CHECKPOINT_OUT_FLAG)){
+            options.checkpoint_out_file = arg.substr(CHECKPOINT_OUT_FLAG.length());
+        }
+        else if (arg.starts_with(CHECKPOINT_EVERY_FLAG)){
+            options.checkpoint_every = stoll(arg.substr(CHECKPOINT_EVERY_FLAG.length()));
+        }
+        else if (arg.starts_with(SAMPLE_EVERY_FLAG)){
+            options.sample_every = stoll(arg.substr(SAMPLE_EVERY_FLAG.length()));
+        }
+        else if (arg.starts_with(SAMPLE_WARMUP_FLAG)){
+            options.sample_warmup = stoi(arg.substr(SAMPLE_WARMUP_FLAG.length()));
+        }
+        else if (arg.starts_with(SAMPLE_WINDOW_FLAG)){
+            options.sample_window = stoi(arg.substr(SAMPLE_WINDOW_FLAG.length()));
+        }
+        else if (arg.starts_with(CACHE_SIZE_FLAG)){
+            options.cache.size = stoi(arg.substr(CACHE_SIZE_FLAG.length()));
+        }
+        else if (arg.starts_with(CACHE_WAYS_FLAG)){
+            options.cache.ways = stoi(arg.substr(CACHE_WAYS_FLAG.length()));
+        }
+        else if (arg.starts_with(CACHE_LINE_FLAG)){
+            options.cache.line_size = stoi(arg.substr(CACHE_LINE_FLAG.length()));
+        }
+        else if (arg.starts_with(CACHE_POLICY_FLAG)){
+            string policy = arg.substr(CACHE_POLICY_FLAG.length());
+            auto name = std::find(std::begin(REPLACEMENT_POLICY_NAMES), std::end(REPLACEMENT_POLICY_NAMES), policy);
+            if (name == std::end(REPLACEMENT_POLICY_NAMES)){
+                cout << "ERROR: unknown replacement policy \"" << policy << "\"!" << endl;
+                return 1;
+            }
+            options.cache.policy = (ReplacementPolicy)(name - std::begin(REPLACEMENT_POLICY_NAMES));
+        }
+        else if (arg.starts_with(CACHE_HIT_FLAG)){
+            options.cache.hit_latency = stoi(arg.substr(CACHE_HIT_FLAG.length()));
+        }
+        else if (arg.starts_with(CACHE_MISS_FLAG)){
+            options.cache.miss_latency = stoi(arg.substr(CACHE_MISS_FLAG.length()));
+        }
+        else if (arg.starts_with(PREDICTOR_FLAG)){
+            string kind = arg.substr(PREDICTOR_FLAG.length());
+            auto name = std::find(std::begin(PREDICTOR_NAMES), std::end(PREDICTOR_NAMES), kind);
+            if (name == std::end(PREDICTOR_NAMES)){
+                cout << "ERROR: unknown branch predictor \"" << kind << "\"!" << endl;
+                return 1;
+            }
+            options.predictor.kind = (PredictorKind)(name - std::begin(PREDICTOR_NAMES));
+        }
+        else if (arg.starts_with(BTB_ENTRIES_FLAG)){
+            options.predictor.btb_entries = stoi(arg.substr(BTB_ENTRIES_FLAG.length()));
+        }
+        else if (arg.starts_with(STATS_OUT_FLAG)){
+            options.stats_out_file = arg.substr(STATS_OUT_FLAG.length());
+        }
+        else if (arg.starts_with(TIMELINE_OUT_FLAG)){
+            options.timeline_out_file = arg.substr(TIMELINE_OUT_FLAG.length());
+        }
+        else if (arg.starts_with(OCCUPANCY_OUT_FLAG)){
+            options.occupancy_out_file = arg.substr(OCCUPANCY_OUT_FLAG.length());
+        }
+        else {
+            filenames.push_back(arg);
+        }
+    }
+
+    if (options.checkpoint_every != 0 && options.checkpoint_out_file.empty()){
+        cout << "ERROR: " << CHECKPOINT_EVERY_FLAG << " needs a file from " << CHECKPOINT_OUT_FLAG << endl;
+        return 1;
+    }
+
+    if (options.sample_every != 0 && (options.sample_window <= 0 || options.sample_warmup < 0 || options.sample_every < (long long)options.sample_warmup + options.sample_window)){
+        cout << "ERROR: sample windows need " << SAMPLE_WINDOW_FLAG << " > 0 and must fit in " << SAMPLE_EVERY_FLAG << endl;
+        return 1;
+    }
+
+    if (not options.stats_out_file.empty() && (options.functional_only || options.sample_every != 0)){
+        cout << "ERROR: stall counters are only kept by runs that time every instruction" << endl;
+        return 1;
+    }
+
+    if (not options.timeline_out_file.empty() && (options.functional_only || options.sample_every != 0)){
+        cout << "ERROR: timelines are only written by runs that time every instruction" << endl;
+        return 1;
+    }
+
+    if (not options.occupancy_out_file.empty() && (options.functional_only || options.sample_every != 0)){
+        cout << "ERROR: occupancy logs are only written by runs that time every instruction" << endl;
+        return 1;
+    }
+
+    if (options.cache.size != 0 && not valid_cache_config(options.cache)){
+        return 1;
+    }
+
+    if (options.predictor.kind != PREDICT_NONE && not valid_predictor_config(options.predictor)){
+        return 1;
+    }
+
+    if (not batch_file.empty()){
+        if (not options.checkpoint_in_file.empty() || not options.checkpoint_out_file.empty()){
+            cout << "ERROR: checkpoints are only written and read by single runs, not by a batch" << endl;
+            return 1;
+        }
+        if (not options.stats_out_file.empty()){
+            cout << "ERROR: stall counters are only written by single runs, not by a batch" << endl;
+            return 1;
+        }
+        if (not options.timeline_out_file.empty()){
+            cout << "ERROR: timelines are only written by single runs, not by a batch" << endl;
+            return 1;
+        }
+        if (not options.occupancy_out_file.empty()){
+            cout << "ERROR: occupancy logs are only written by single runs, not by a batch" << endl;
+            return 1;
+        }
+        run_batch(read_manifest(batch_file), options, num_threads);
+        return 0;
+    }
 
     // assign default/specified filenames
-    if (argc < EXPECTED_NUM_ARGS){
+    if (filenames.size() < EXPECTED_NUM_FILES){
 
         // use defaults filenames
         instruction_file = DEFAULT_INST_FILE;
@@ -31,15 +289,57 @@ int main(const int argc, const char* argv[]){
     else {
 
         // use command line arguments
-        instruction_file = argv[1];
-        data_file = argv[2];
-        output_file = argv[3];
+        instruction_file = filenames[0];
+        data_file = filenames[1];
+        output_file = filenames[2];
     }
 
     Memory memory;
-    load_program(memory.program, instruction_file);
-    load_data(memory.data, data_file);
-    run_program(memory, output_file);
+    std::shared_ptr<Program> program = std::make_shared<Program>();
+    vector<std::bitset<REG_SIZE>> data_segment;
+    if (not image_in_file.empty()){
+        if (not load_image(*program, data_segment, image_in_file, 0, 0)){
+            cout << "ERROR: " << image_in_file << " is not an image written by this simulator!" << endl;
+            return 1;
+        }
+    }
+    else if (use_image_cache){
+        load_with_image_cache(*program, data_segment, instruction_file, data_file);
+    }
+    else {
+        load_program(*program, instruction_file);
+        if (trace_in_file.empty()){
+            load_data(data_segment, data_file);
+        }
+    }
+    memory.program = program;
+    load_segment(memory.data, data_segment);
+
+    if (not image_out_file.empty()){
+        write_image(*program, data_segment, image_out_file, hash_file(instruction_file), hash_file(data_file));
+    }
+
+    if (not trace_in_file.empty()){
+        replay_trace(*memory.program, trace_in_file, options, output_file);
+        return 0;
+    }
+
+    if (not trace_out_file.empty()){
+        long long num_records = write_trace(memory, trace_out_file);
+        write_state(memory, output_file);
+        cout << "Traced " << num_records << " instructions" << endl;
+    }
+    else if (options.functional_only){
+        long long executed = run_functional(memory, options.use_jit);
+        write_state(memory, output_file);
+        cout << "Executed " << executed << " instructions" << endl;
+    }
+    else if (options.sample_every != 0){
+        run_sampled(memory, options, output_file);
+    }
+    else {
+        run_program(memory, options, output_file);
+    }
 
     return 0;
 }
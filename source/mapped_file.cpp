@@ -0,0 +1,91 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+using std::string;
+
+MappedFile map_file(const string& filename)
+{
+    MappedFile file;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return file;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1)
+    {
+        close(fd);
+        return file;
+    }
+
+    // mmap refuses empty mappings, an empty file is just an empty range
+    file.is_open = true;
+    if (info.st_size == 0)
+    {
+        close(fd);
+        return file;
+    }
+
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        file.is_open = false;
+        return file;
+    }
+    madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+    file.begin = (const char*)mapping;
+    file.size = info.st_size;
+    return file;
+}
+
+void unmap_file(MappedFile& file)
+{
+    if (file.begin)
+    {
+        munmap((void*)file.begin, file.size);
+    }
+    file.begin = nullptr;
+    file.size = 0;
+    file.is_open = false;
+}
+
+uint64_t hash_bytes(const char* bytes, const size_t size)
+{
+    const uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = size * MULTIPLIER;
+
+    // eight bytes at a time, then whatever is left
+    size_t ii = 0;
+    for (; ii + sizeof(uint64_t) <= size; ii += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + ii, sizeof(word));
+        hash = (hash ^ word) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    for (; ii < size; ii++)
+    {
+        hash = (hash ^ (unsigned char)bytes[ii]) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+uint64_t hash_file(const string& filename)
+{
+    MappedFile file = map_file(filename);
+    if (not file.is_open)
+    {
+        return 0;
+    }
+    uint64_t hash = hash_bytes(file.begin, file.size);
+    unmap_file(file);
+    return hash;
+}
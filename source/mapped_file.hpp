@@ -0,0 +1,24 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// a whole file mapped read-only into memory
+struct MappedFile {
+    const char* begin = nullptr;
+    size_t size = 0;
+    bool is_open = false; // false if the file could not be opened, an empty file is open with size 0
+};
+
+MappedFile map_file(const std::string& filename);
+void unmap_file(MappedFile& file);
+
+// 64 bit hash of a block of bytes, used to tell when a file has changed
+uint64_t hash_bytes(const char* bytes, const size_t size);
+
+// hash of a whole file's contents, 0 if it could not be opened
+uint64_t hash_file(const std::string& filename);
+
+#endif
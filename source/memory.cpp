@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <vector>
+#include "memory.hpp"
+using std::bitset;
+using std::vector;
+
+uint32_t* touch_page(DataMemory& memory, const uint32_t page_number)
+{
+    std::unique_ptr<PageTable>& table = memory.tables[page_number >> TABLE_BITS];
+    if (not table)
+    {
+        table = std::make_unique<PageTable>();
+    }
+
+    std::unique_ptr<uint32_t[]>& page = table->pages[page_number & (PAGES_PER_TABLE - 1)];
+    if (not page)
+    {
+        page = std::make_unique<uint32_t[]>(WORDS_PER_PAGE);
+    }
+
+    memory.last_page = page.get();
+    memory.last_page_number = page_number;
+    return page.get();
+}
+
+uint32_t peek_word(const DataMemory& memory, const uint32_t address)
+{
+    uint32_t page_number = address >> PAGE_BITS;
+    const std::unique_ptr<PageTable>& table = memory.tables[page_number >> TABLE_BITS];
+    if (not table)
+    {
+        return 0;
+    }
+    const std::unique_ptr<uint32_t[]>& page = table->pages[page_number & (PAGES_PER_TABLE - 1)];
+    if (not page)
+    {
+        return 0;
+    }
+    return page[(address & (PAGE_SIZE - 1)) >> 2];
+}
+
+vector<uint32_t> resident_pages(const DataMemory& memory)
+{
+    vector<uint32_t> page_numbers;
+    for (int ii = 0; ii < NUM_PAGE_TABLES; ii++)
+    {
+        if (not memory.tables[ii])
+        {
+            continue;
+        }
+        for (int jj = 0; jj < PAGES_PER_TABLE; jj++)
+        {
+            if (memory.tables[ii]->pages[jj])
+            {
+                page_numbers.push_back(((uint32_t)ii << TABLE_BITS) | jj);
+            }
+        }
+    }
+    return page_numbers;
+}
+
+void clear_data(DataMemory& memory)
+{
+    for (int ii = 0; ii < NUM_PAGE_TABLES; ii++)
+    {
+        memory.tables[ii].reset();
+    }
+    memory.last_page = nullptr;
+    memory.last_page_number = NO_PAGE;
+    memory.num_segment_words = 0;
+}
+
+void load_segment(DataMemory& memory, const vector<bitset<REG_SIZE>>& words)
+{
+    clear_data(memory);
+    for (unsigned int ii = 0; ii < words.size(); ii++)
+    {
+        data_word(memory, DATA_SEGMENT_START + ii * 4) = words[ii].to_ulong();
+    }
+    memory.num_segment_words = words.size();
+}
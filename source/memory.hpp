@@ -1,6 +1,8 @@
 #ifndef MEMORY_HPP
 #define MEMORY_HPP
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <bitset>
 #include <unordered_map>
@@ -10,13 +12,69 @@
 const int REG_SIZE = 32;
 const int NUM_REGS = 32;
 
+const uint32_t DATA_SEGMENT_START = 256; // address the first word of the data file is loaded at
+const int PAGE_BITS = 12; // 4 KiB pages
+const uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+const int WORDS_PER_PAGE = PAGE_SIZE / 4;
+const int TABLE_BITS = 10; // the low bits of a page number pick its entry in a PageTable, the rest pick the table
+const int PAGES_PER_TABLE = 1 << TABLE_BITS;
+const int NUM_PAGE_TABLES = 1 << (32 - PAGE_BITS - TABLE_BITS);
+const uint32_t NO_PAGE = UINT32_MAX; // never a page number, page numbers only have 32 - PAGE_BITS bits
+
+// second level of the page table, pages are allocated the first time anything in them is touched
+struct PageTable {
+    std::unique_ptr<uint32_t[]> pages[PAGES_PER_TABLE];
+};
+
+// the whole 32 bit data address space, only the pages that were touched take up memory
+// untouched words read as 0, addresses are word aligned by dropping their low two bits
+struct DataMemory {
+    // page the last access landed in, checked before walking the table
+    // the JIT reads both at fixed offsets, keep the struct standard layout
+    uint32_t* last_page = nullptr;
+    uint32_t last_page_number = NO_PAGE;
+
+    std::unique_ptr<PageTable> tables[NUM_PAGE_TABLES];
+
+    // words loaded from the data file, the part write_state() lists in the loaded format
+    uint32_t num_segment_words = 0;
+};
+
 struct Memory{
     // program loaded from input file
-    Program program;
+    // shared read-only, many runs can use the same parsed program at once
+    std::shared_ptr<const Program> program;
 
-    // data from the data file, still in bits
+    // data memory, the data file's words start at DATA_SEGMENT_START
     // filled when data file is parsed, changes during runtime
-    std::vector<std::bitset<REG_SIZE>> data;
+    DataMemory data;
+
+    // register file, all zero at the start of a run
+    // left holding the final values once a run finishes
+    std::vector<std::bitset<REG_SIZE>> registers = std::vector<std::bitset<REG_SIZE>>(NUM_REGS, 0);
 };
 
+// walks the table to a page, allocating it (and its table) if it was never touched, and makes it the last page
+uint32_t* touch_page(DataMemory& memory, const uint32_t page_number);
+
+// the word an address falls in, allocated on first touch
+inline uint32_t& data_word(DataMemory& memory, const uint32_t address)
+{
+    uint32_t page_number = address >> PAGE_BITS;
+    uint32_t* page = page_number == memory.last_page_number ? memory.last_page : touch_page(memory, page_number);
+    return page[(address & (PAGE_SIZE - 1)) >> 2];
+}
+
+// reads a word without allocating anything, 0 if its page was never touched
+uint32_t peek_word(const DataMemory& memory, const uint32_t address);
+
+// numbers of every page that has been touched, in address order
+std::vector<uint32_t> resident_pages(const DataMemory& memory);
+
+// frees every page, everything reads as 0 again
+void clear_data(DataMemory& memory);
+
+// replaces the data memory with a data file's words from DATA_SEGMENT_START
+void load_segment(DataMemory& memory, const std::vector<std::bitset<REG_SIZE>>& words);
+
 #endif
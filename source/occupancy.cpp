@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <iostream>
+#include "occupancy.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::string;
+
+// Kanata lines are tab separated, so a line of the program loses its tabs in the label
+static void append_label(string& out, const string& text)
+{
+    for (char character : text)
+    {
+        out += character == '\t' ? ' ' : character;
+    }
+}
+
+// lines are written in cycle order, moving the log's cycle on first if this one is later
+static void advance(OccupancyWriter& writer, const long long cycle)
+{
+    if (cycle > writer.cycle)
+    {
+        writer.output.filling += "C\t" + std::to_string(cycle - writer.cycle) + "\n";
+        writer.cycle = cycle;
+    }
+}
+
+// every line about an instruction starts with the command and its id, the log's ids count from 0
+static void append_command(OccupancyWriter& writer, const char command, const Instruction& instr)
+{
+    writer.output.filling += command;
+    writer.output.filling += '\t';
+    writer.output.filling += std::to_string(instr.instr_index - writer.first_index);
+    writer.output.filling += '\t';
+}
+
+static void append_stage(OccupancyWriter& writer, const char command, const Instruction& instr, const int lane, const Stage stage)
+{
+    append_command(writer, command, instr);
+    writer.output.filling += std::to_string(lane);
+    writer.output.filling += '\t';
+    writer.output.filling += writer.config->stage_names[stage];
+    writer.output.filling += '\n';
+}
+
+// the instruction's line in the viewer, with the line of the program it came from
+static void start_instruction(OccupancyWriter& writer, const Instruction& instr, const Stage stage)
+{
+    append_command(writer, 'I', instr);
+    writer.output.filling += std::to_string(instr.instr_index) + "\t0\n";
+    append_command(writer, 'L', instr);
+    writer.output.filling += "0\t" + std::to_string(instr.line_number) + ": ";
+    append_label(writer.output.filling, get_original_line(*writer.program, instr));
+    writer.output.filling += '\n';
+    append_stage(writer, 'S', instr, OCCUPANCY_MAIN_LANE, stage);
+}
+
+// closes the stage the instruction is leaving, in both lanes if it was stalled there
+static void end_stage(OccupancyWriter& writer, const Instruction& instr, const Stage stage)
+{
+    if (writer.stalled[stage] == instr.instr_index + 1)
+    {
+        append_stage(writer, 'E', instr, OCCUPANCY_STALL_LANE, stage);
+        writer.stalled[stage] = 0;
+    }
+    append_stage(writer, 'E', instr, OCCUPANCY_MAIN_LANE, stage);
+}
+
+bool open_occupancy(OccupancyWriter& writer, const string& filename, const Program& program, const PipelineConfig& config,
+                    Instruction* const* active_instrs, const long long first_index, const long long first_cycle)
+{
+    open_output(writer.output, filename, false);
+    if (not writer.output.file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        close_output(writer.output);
+        return false;
+    }
+    writer.program = &program;
+    writer.config = &config;
+    writer.first_index = first_index;
+    writer.cycle = first_cycle;
+    std::fill(writer.stalled, writer.stalled + MAX_STAGES, 0);
+
+    writer.output.filling += OCCUPANCY_HEADER;
+    writer.output.filling += "C=\t" + std::to_string(first_cycle) + "\n";
+
+    // oldest first, as if they had just been fetched
+    for (Stage ii = config.num_stages - 1; ii >= 0; ii--)
+    {
+        if (active_instrs[ii])
+        {
+            start_instruction(writer, *active_instrs[ii], ii);
+        }
+    }
+    hand_off_if_full(writer.output);
+    return true;
+}
+
+void occupancy_fetch(OccupancyWriter& writer, const Instruction& instr, const long long cycle)
+{
+    advance(writer, cycle);
+    start_instruction(writer, instr, IF);
+    hand_off_if_full(writer.output);
+}
+
+void occupancy_push(OccupancyWriter& writer, const Instruction& instr, const Stage stage, const long long cycle)
+{
+    advance(writer, cycle + 1);
+    end_stage(writer, instr, stage);
+    if (stage != writer.config->writeback_stage())
+    {
+        append_stage(writer, 'S', instr, OCCUPANCY_MAIN_LANE, stage + 1);
+    }
+    else
+    {
+        append_command(writer, 'R', instr);
+        writer.output.filling += std::to_string(instr.instr_index - writer.first_index) + "\t0\n";
+    }
+    hand_off_if_full(writer.output);
+}
+
+void occupancy_stall(OccupancyWriter& writer, const Instruction& instr, const Stage stage, const long long cycle)
+{
+    if (writer.stalled[stage] == instr.instr_index + 1)
+    {
+        return;
+    }
+    advance(writer, cycle + 1);
+    append_stage(writer, 'S', instr, OCCUPANCY_STALL_LANE, stage);
+    writer.stalled[stage] = instr.instr_index + 1;
+    hand_off_if_full(writer.output);
+}
+
+void close_occupancy(OccupancyWriter& writer, Instruction* const* active_instrs, const long long last_cycle)
+{
+    advance(writer, last_cycle + 1);
+    for (Stage ii = writer.config->num_stages - 1; ii >= 0; ii--)
+    {
+        if (active_instrs[ii])
+        {
+            end_stage(writer, *active_instrs[ii], ii);
+            append_command(writer, 'R', *active_instrs[ii]);
+            writer.output.filling += std::to_string(active_instrs[ii]->instr_index - writer.first_index) + "\t1\n";
+        }
+    }
+    close_output(writer.output);
+}
@@ -0,0 +1,45 @@
+#ifndef OCCUPANCY_HPP
+#define OCCUPANCY_HPP
+
+#include <string>
+#include "instruction.hpp"
+#include "output.hpp"
+#include "program.hpp"
+#include "stage.hpp"
+
+// header of the Kanata log format read by the Konata pipeline viewer
+const std::string OCCUPANCY_HEADER = "Kanata\t0004\n";
+
+// lanes of a Kanata log, a stage is drawn in the main lane and again in the stall lane while it is held past its latency
+const int OCCUPANCY_MAIN_LANE = 0;
+const int OCCUPANCY_STALL_LANE = 1;
+
+// streams which instruction is in which stage as the pipeline moves them, every line is written at the cycle it
+// happens, so nothing but the stalled instruction of each stage is remembered
+struct OccupancyWriter {
+    OutputWriter output;
+    const Program* program = nullptr;
+    const PipelineConfig* config = nullptr;
+    long long first_index = 0; // instr_index of the log's instruction 0
+    long long cycle = 0; // cycle the lines written last happen at
+    long long stalled[MAX_STAGES] = {}; // instr_index + 1 of the instruction held in each stage past its latency, 0 if none
+};
+
+// starts the log at first_cycle, instructions already in flight (after a checkpoint) start in the stage they are in
+// the log numbers instructions from first_index, the oldest one that can still be in flight
+bool open_occupancy(OccupancyWriter& writer, const std::string& filename, const Program& program, const PipelineConfig& config,
+                    Instruction* const* active_instrs, const long long first_index, const long long first_cycle);
+
+// the instruction entered IF this cycle
+void occupancy_fetch(OccupancyWriter& writer, const Instruction& instr, const long long cycle);
+
+// the instruction left the stage at the end of this cycle, into the next one or out of WB
+void occupancy_push(OccupancyWriter& writer, const Instruction& instr, const Stage stage, const long long cycle);
+
+// the instruction used up the stage's latency this cycle without leaving, it stalls from the next one
+void occupancy_stall(OccupancyWriter& writer, const Instruction& instr, const Stage stage, const long long cycle);
+
+// ends the stages of every instruction still in flight at the end of last_cycle, flushing them, and closes the log
+void close_occupancy(OccupancyWriter& writer, Instruction* const* active_instrs, const long long last_cycle);
+
+#endif
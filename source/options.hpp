@@ -0,0 +1,34 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+#include "cache.hpp"
+#include "predictor.hpp"
+#include "stage.hpp"
+
+const long long DEFAULT_CYCLE_LIMIT = 100;
+const int DEFAULT_SAMPLE_WARMUP = 2000;
+const int DEFAULT_SAMPLE_WINDOW = 1000;
+
+// settings picked on the command line that change how a program is run
+struct Options {
+    long long cycle_limit = DEFAULT_CYCLE_LIMIT; // stop after this many cycles, 0 runs until the program finishes
+    bool echo_output = true; // also print each row of the cycle table to the console
+    bool functional_only = false; // skip the pipeline, only the final registers and data are written
+    bool use_jit = true; // functional runs translate hot blocks to native code where the host is supported
+    const PipelineConfig* pipeline = DEFAULT_PIPELINE; // shape of the pipeline being timed
+    bool skip_quiet_cycles = true; // jump over cycles where nothing but a latency counter changes
+    std::string checkpoint_in_file; // resume from this checkpoint instead of cycle 1, empty to start from the beginning
+    std::string checkpoint_out_file; // where checkpoints are written, empty for none
+    long long checkpoint_every = 0; // cycles between checkpoints, 0 writes one when the run stops
+    long long sample_every = 0; // instructions between the starts of sample windows, 0 times the whole program
+    int sample_warmup = DEFAULT_SAMPLE_WARMUP; // instructions that fill the pipeline before a window is measured
+    int sample_window = DEFAULT_SAMPLE_WINDOW; // instructions measured per window
+    CacheConfig cache; // L1 data cache behind LW and SW, size 0 keeps MEM at its stage latency
+    PredictorConfig predictor; // how fetch guesses past branches, PREDICT_NONE waits for each to resolve
+    std::string stats_out_file; // where the stall counters of a timed run are written, empty to compile them out
+    std::string timeline_out_file; // where every instruction's finish cycles are written in binary, empty for none
+    std::string occupancy_out_file; // where the stage every instruction is in each cycle is logged for Konata, empty for none
+};
+
+#endif
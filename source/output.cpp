@@ -0,0 +1,128 @@
+#include <charconv>
+#include <iostream>
+#include "output.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::string;
+
+const unsigned int NUM_PAD_SPACES = 35;
+
+// runs on the writer thread until close_output(), each buffer goes to the file and then the console
+static void write_buffers(OutputWriter* writer)
+{
+    std::unique_lock<std::mutex> guard(writer->lock);
+    while (true)
+    {
+        writer->changed.wait(guard, [writer] { return not writer->writing.empty() || writer->closing; });
+        if (writer->writing.empty())
+        {
+            return;
+        }
+
+        // the main thread only touches writing again once it is empty
+        guard.unlock();
+        writer->file.write(writer->writing.data(), writer->writing.size());
+        if (writer->echo)
+        {
+            cout.write(writer->writing.data(), writer->writing.size());
+        }
+        guard.lock();
+
+        writer->writing.clear();
+        writer->changed.notify_all();
+    }
+}
+
+// waits for the thread to finish the last buffer, then gives it this one and keeps the old one to refill
+static void hand_off(OutputWriter& writer)
+{
+    std::unique_lock<std::mutex> guard(writer.lock);
+    writer.changed.wait(guard, [&writer] { return writer.writing.empty(); });
+    writer.filling.swap(writer.writing);
+    writer.changed.notify_all();
+}
+
+void open_output(OutputWriter& writer, const string& filename, const bool echo)
+{
+    writer.file.open(filename, std::ofstream::trunc);
+    writer.echo = echo;
+    writer.filling.reserve(OUTPUT_BUFFER_SIZE + 256);
+    writer.writing.reserve(OUTPUT_BUFFER_SIZE + 256);
+    writer.thread = std::thread(write_buffers, &writer);
+}
+
+void format_output_header(string& out, const PipelineConfig& config)
+{
+    out += "Cycle Number for Each Stage        ";
+    out += config.stage_names[IF];
+    out += '\t';
+    out += config.stage_names[ID];
+    out += '\t';
+    out += config.stage_names[config.last_execute_stage()];
+    out += '\t';
+    out += config.stage_names[config.memory_stage()];
+    out += '\t';
+    out += config.stage_names[config.writeback_stage()];
+    out += '\n';
+}
+
+void format_output_row(string& out, const Program& program, const Instruction& instruction, const PipelineConfig& config)
+{
+    const string& original_line = get_original_line(program, instruction);
+    out += original_line;
+
+    // pad everything to 35 spaces, then align with tabs
+    if (original_line.length() < NUM_PAD_SPACES)
+    {
+        out.append(NUM_PAD_SPACES - original_line.length(), ' ');
+    }
+
+    const Stage COLUMNS[] = {IF, ID, config.last_execute_stage(), config.memory_stage(), config.writeback_stage()};
+    const int NUM_COLUMNS = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+    char digits[24];
+    for (int ii = 0; ii < NUM_COLUMNS; ii++)
+    {
+        char* end = std::to_chars(digits, digits + sizeof(digits), instruction.finish_log[COLUMNS[ii]]).ptr;
+        out.append(digits, end);
+        out += ii + 1 < NUM_COLUMNS ? '\t' : '\n';
+    }
+}
+
+void hand_off_if_full(OutputWriter& writer)
+{
+    if (writer.filling.size() >= OUTPUT_BUFFER_SIZE)
+    {
+        hand_off(writer);
+    }
+}
+
+void write_output_row(OutputWriter& writer, const Program& program, const Instruction& instruction, const PipelineConfig& config)
+{
+    format_output_row(writer.filling, program, instruction, config);
+    hand_off_if_full(writer);
+}
+
+void write_output_text(OutputWriter& writer, const string& text)
+{
+    writer.filling += text;
+    hand_off_if_full(writer);
+}
+
+void close_output(OutputWriter& writer)
+{
+    if (not writer.filling.empty())
+    {
+        hand_off(writer);
+    }
+    {
+        std::lock_guard<std::mutex> guard(writer.lock);
+        writer.closing = true;
+        writer.changed.notify_all();
+    }
+    writer.thread.join();
+    writer.file.close();
+    if (writer.echo)
+    {
+        cout.flush();
+    }
+}
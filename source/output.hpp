@@ -0,0 +1,47 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "instruction.hpp"
+#include "program.hpp"
+#include "stage.hpp"
+
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20; // bytes of rows formatted before they are handed to the writer thread
+
+// the cycle table of a timed run, rows are formatted into one buffer while a background thread writes the other
+// to the output file, and to the console if echo is set
+struct OutputWriter {
+    std::ofstream file;
+    bool echo = false;
+    std::string filling; // formatted since the last hand off
+    std::string writing; // being written by the thread, empty once it is done so the buffers can swap
+    bool closing = false;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread thread;
+};
+
+// truncates the output file and starts the writer thread
+void open_output(OutputWriter& writer, const std::string& filename, const bool echo);
+
+// the table shows IF, ID, the last execute stage, MEM and WB of whichever pipeline was timed
+void format_output_header(std::string& out, const PipelineConfig& config);
+void format_output_row(std::string& out, const Program& program, const Instruction& instruction, const PipelineConfig& config);
+
+// for text formatted straight into filling, hands the buffer to the thread once it is full
+void hand_off_if_full(OutputWriter& writer);
+
+// adds a row to the table, handing the buffer to the thread once it is full
+void write_output_row(OutputWriter& writer, const Program& program, const Instruction& instruction, const PipelineConfig& config);
+
+// adds text after the table, such as the cache and predictor reports
+void write_output_text(OutputWriter& writer, const std::string& text);
+
+// writes whatever is still buffered and waits for the thread to finish
+void close_output(OutputWriter& writer);
+
+#endif
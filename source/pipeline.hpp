@@ -0,0 +1,76 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <cstdint>
+#include "cache.hpp"
+#include "flag_reg.hpp"
+#include "instruction.hpp"
+#include "memory.hpp"
+#include "occupancy.hpp"
+#include "predictor.hpp"
+#include "stage.hpp"
+
+// power of two larger than MAX_STAGES, so a slot is only reused once its instruction has retired
+const int WINDOW_SIZE = 16;
+
+// every instruction currently in flight, memory use does not grow with the length of a run
+struct Pipeline {
+    // ring of in-flight instructions, instruction number i lives in window[i % WINDOW_SIZE]
+    Instruction window[WINDOW_SIZE];
+
+    // instruction in each stage, nullptr if the stage is empty (basically stage regs)
+    Instruction* active_instrs[MAX_STAGES] = {};
+
+    long long num_fetched = 0; // instr_index the next fetched instruction gets
+    long long num_retired = 0; // every instruction with a lower instr_index has left WB
+
+    // registers with a write still on its way, bit i is register i
+    // set when an instruction issues (leaves ID), cleared when it writes back, so a hazard check is a single AND
+    uint32_t pending_writes = 0;
+    long long last_writer[NUM_REGS] = {}; // instr_index of the youngest issued instruction writing each register
+
+    // bumped whenever an instruction moves or makes progress, a cycle that leaves it alone changed nothing
+    long long num_changes = 0;
+
+    // decides how long LW and SW spend in MEM, nullptr gives every instruction the stage's latency
+    // owned by whoever runs the pipeline, a sampled run keeps one warm across its windows
+    DataCache* cache = nullptr;
+
+    // lets fetch carry on past branches it predicts correctly, nullptr stops behind every branch
+    // owned the same way as the cache
+    BranchPredictor* predictor = nullptr;
+
+    // told about every fetch, move and stall for --occupancy-out=, nullptr when no log is kept
+    OccupancyWriter* occupancy = nullptr;
+};
+
+// occupancy and hazards of every stage, taken once a cycle after fetch so each stage's decision is a lookup
+// only occupied changes while the stages run, it is kept up to date as instructions move up
+struct ControlSnapshot {
+    uint32_t occupied = 0; // bit per stage holding an instruction
+    uint32_t held = 0; // bit per stage whose instruction waits on a data hazard or on its stage's latency
+    uint32_t finishing = 0; // bit per stage whose instruction completes when it moves on
+    bool frozen = false; // IF is empty and the program is not finishing up, every stage repeats the last decision made (legacy behaviour)
+};
+
+// what the stages were up against as a cycle started, so the cycles they lose can be charged to a StallReason
+// only taken when stalls are counted (--stats-out=)
+struct CycleCauses {
+    const Instruction* instrs[MAX_STAGES] = {};
+    uint32_t occupied = 0; // bit per stage holding an instruction
+    uint32_t data_held = 0; // bit per stage whose instruction waits on a source register
+    bool memory_busy = false; // MEM's access still has cycles to go
+    const Instruction* unresolved_branch = nullptr; // branch or jump that fetch is waiting on, if any
+};
+
+// everything the next cycle's decisions depend on, apart from the cycle number and each stage_cycles
+// if a cycle ends with the same snapshot it started with, the cycles after it repeat it until a latency runs out
+struct PipelineSnapshot {
+    FlagReg flags;
+    long long num_fetched = 0;
+    long long num_changes = 0;
+
+    bool operator==(const PipelineSnapshot& other) const = default;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include <bit>
+#include <iomanip>
+#include <iostream>
+#include "predictor.hpp"
+using std::cout;
+using std::endl;
+using std::setw;
+
+bool valid_predictor_config(const PredictorConfig& config)
+{
+    if (config.btb_entries < 1 || config.btb_entries > MAX_BTB_ENTRIES || not std::has_single_bit((unsigned int)config.btb_entries))
+    {
+        cout << "ERROR: the BTB must have a power of two number of entries, at most " << MAX_BTB_ENTRIES << "!" << endl;
+        return false;
+    }
+    return true;
+}
+
+void start_predictor(BranchPredictor& predictor, const PredictorConfig& config, const int num_lines)
+{
+    predictor = BranchPredictor();
+    predictor.config = config;
+
+    // 2 bit counters start weakly not taken, so one taken outcome does not flip them
+    predictor.counters.assign(PREDICTOR_TABLE_SIZE, config.kind == PREDICT_ONE_BIT ? 0 : 1);
+    predictor.btb.assign(config.btb_entries, NO_BRANCH);
+    predictor.stats.assign(num_lines, BranchStats());
+}
+
+bool predict_branch(BranchPredictor& predictor, const int pc, const bool is_jump, const bool taken)
+{
+    uint32_t index = pc;
+    if (predictor.config.kind == PREDICT_GSHARE)
+    {
+        index ^= predictor.history;
+    }
+    index &= PREDICTOR_TABLE_SIZE - 1;
+    uint8_t& counter = predictor.counters[index];
+
+    bool predict_taken = is_jump;
+    if (not is_jump)
+    {
+        switch (predictor.config.kind)
+        {
+        case PREDICT_ONE_BIT:
+            predict_taken = counter;
+            break;
+        case PREDICT_TWO_BIT:
+        case PREDICT_GSHARE:
+            predict_taken = counter >= 2;
+            break;
+        default:
+            predict_taken = false;
+            break;
+        }
+    }
+
+    // a taken prediction only redirects fetch if the BTB has the branch
+    int32_t& btb_entry = predictor.btb[pc & (predictor.config.btb_entries - 1)];
+    bool correct = predict_taken ? taken && btb_entry == pc : not taken;
+
+    if (not is_jump)
+    {
+        if (predictor.config.kind == PREDICT_ONE_BIT)
+        {
+            counter = taken;
+        }
+        else if (taken && counter < 3)
+        {
+            counter++;
+        }
+        else if (not taken && counter > 0)
+        {
+            counter--;
+        }
+        predictor.history = (predictor.history << 1) | taken;
+    }
+    if (taken)
+    {
+        btb_entry = pc;
+    }
+
+    if (pc >= 0 && pc < (int)predictor.stats.size())
+    {
+        predictor.stats[pc].executed++;
+        predictor.stats[pc].correct += correct;
+    }
+    return correct;
+}
+
+void write_predictor_report(std::ostream& out, const BranchPredictor& predictor, const Program& program)
+{
+    out << "Branch predictor: " << PREDICTOR_NAMES[predictor.config.kind] << ", " << predictor.config.btb_entries << " entry BTB" << endl;
+    out << "Line    Executed     Correct  Accuracy  Instruction" << endl;
+
+    int64_t executed = 0;
+    int64_t correct = 0;
+    out << std::fixed << std::setprecision(2);
+    for (unsigned int ii = 0; ii < predictor.stats.size(); ii++)
+    {
+        const BranchStats& stats = predictor.stats[ii];
+        if (stats.executed == 0)
+        {
+            continue;
+        }
+        executed += stats.executed;
+        correct += stats.correct;
+
+        out << std::left << setw(5) << ii + 1 << std::right << setw(11) << stats.executed << setw(12) << stats.correct
+            << setw(9) << 100.0 * stats.correct / stats.executed << "%  ";
+        out << (ii < program.original_lines.size() ? program.original_lines[ii] : "") << endl;
+    }
+    out << "Overall: " << correct << " of " << executed << " branches predicted (" << (executed == 0 ? 0.0 : 100.0 * correct / executed) << "%)" << endl;
+    out << std::defaultfloat << std::setprecision(6);
+}
@@ -0,0 +1,56 @@
+#ifndef PREDICTOR_HPP
+#define PREDICTOR_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "program.hpp"
+
+const int PREDICTOR_TABLE_BITS = 10; // counters indexed by the low bits of the PC (xor the history for gshare)
+const int PREDICTOR_TABLE_SIZE = 1 << PREDICTOR_TABLE_BITS;
+const int DEFAULT_BTB_ENTRIES = 64;
+const int MAX_BTB_ENTRIES = 1 << 16;
+const int32_t NO_BRANCH = -1; // empty BTB entry
+
+// how the direction of BEQ and BNE is guessed at fetch, J is always taken
+// PREDICT_NONE stops fetching behind every branch until it resolves, as the pipeline always has
+enum PredictorKind {PREDICT_NONE = 0, PREDICT_NOT_TAKEN, PREDICT_ONE_BIT, PREDICT_TWO_BIT, PREDICT_GSHARE};
+const char* const PREDICTOR_NAMES[] = {"none", "not-taken", "1bit", "2bit", "gshare"};
+
+struct PredictorConfig {
+    PredictorKind kind = PREDICT_NONE;
+    int btb_entries = DEFAULT_BTB_ENTRIES; // direct mapped, a branch predicted taken needs its PC in here to be fetched past
+
+    bool operator==(const PredictorConfig& other) const = default;
+};
+
+// how often one branch was fetched past on the right path
+struct BranchStats {
+    int64_t executed = 0;
+    int64_t correct = 0;
+};
+
+// predictor tables and the BTB, trained with each branch's outcome as it is fetched
+// every target in the program is static, so a BTB entry only has to remember which branch it holds
+struct BranchPredictor {
+    PredictorConfig config;
+    std::vector<uint8_t> counters; // 1 bit last outcome or 2 bit saturating counter per entry
+    uint32_t history = 0; // outcomes of the latest branches, newest in bit 0 (gshare)
+    std::vector<int32_t> btb; // PC of the branch each entry holds, NO_BRANCH if empty
+    std::vector<BranchStats> stats; // indexed by PC
+};
+
+// true if the settings can be modelled, prints what is wrong otherwise
+bool valid_predictor_config(const PredictorConfig& config);
+
+// sizes an untrained predictor for a program of num_lines lines
+void start_predictor(BranchPredictor& predictor, const PredictorConfig& config, const int num_lines);
+
+// predicts the branch or jump at pc, then trains on what it actually did
+// returns true if fetch could carry on past it: right direction, and its target was in the BTB if taken
+bool predict_branch(BranchPredictor& predictor, const int pc, const bool is_jump, const bool taken);
+
+// accuracy of every branch that was fetched, written after the cycle table
+void write_predictor_report(std::ostream& out, const BranchPredictor& predictor, const Program& program);
+
+#endif
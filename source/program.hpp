@@ -1,16 +1,21 @@
 #ifndef PROGRAM_HPP
 #define PROGRAM_HPP
 
+#include <string>
 #include <vector>
 #include <unordered_map>
 #include "instruction.hpp"
 
 struct Program {
-    // instructions from the program input file
+    // decoded instructions from the program input file
     // filled when instruction file is parsed, does not change during runtime
     std::vector<Instruction> instructions;
 
-    // map of each string label to the line number of its instruction
+    // each instruction's line as it appeared in the input file, indexed by line number - 1
+    // only used when writing output
+    std::vector<std::string> original_lines;
+
+    // map of each string label to the line number of its instruction, line numbers themselves are not stored
     // filled when instruction file is parsed, does not change during runtime
     std::unordered_map<std::string, int> labels;
 };
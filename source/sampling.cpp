@@ -0,0 +1,155 @@
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sampling.hpp"
+#include "cache.hpp"
+#include "predictor.hpp"
+#include "functional.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::setw;
+using std::string;
+using std::vector;
+
+void run_sampled(Memory& memory, const Options& options, const string& output_file)
+{
+    FunctionalState functional;
+    start_functional(functional, memory);
+    if (options.use_jit)
+    {
+        enable_jit(functional);
+    }
+
+    int num_traced = options.sample_warmup + options.sample_window;
+    vector<TraceRecord> records = vector<TraceRecord>(num_traced);
+    vector<SampleWindow> windows;
+
+    // one cache for every window, so each one starts with what the windows before it left behind
+    DataCache cache;
+    DataCache* window_cache = nullptr;
+    if (options.cache.size != 0)
+    {
+        start_cache(cache, options.cache);
+        window_cache = &cache;
+    }
+    BranchPredictor predictor;
+    BranchPredictor* window_predictor = nullptr;
+    if (options.predictor.kind != PREDICT_NONE)
+    {
+        start_predictor(predictor, options.predictor, memory.program->instructions.size());
+        window_predictor = &predictor;
+    }
+
+    // every period starts with a timed window from a cold pipeline, the rest of it is only executed
+    while (not functional.halted)
+    {
+        int num_records = step_functional(functional, memory, records.data(), num_traced);
+        if (num_records > options.sample_warmup)
+        {
+            windows.push_back(time_sample_window(records.data(), num_records, options.sample_warmup, options, window_cache, window_predictor));
+        }
+        fast_forward_functional(functional, memory, options.sample_every - num_traced);
+    }
+    finish_functional(functional, memory);
+
+    ofstream file;
+    file.open(output_file, ofstream::trunc);
+    write_sample_report(file, windows, functional.executed, options);
+    if (window_cache)
+    {
+        write_cache_report(file, cache);
+    }
+    if (window_predictor)
+    {
+        write_predictor_report(file, predictor, *memory.program);
+    }
+    file.close();
+    if (options.echo_output)
+    {
+        write_sample_report(cout, windows, functional.executed, options);
+        if (window_cache)
+        {
+            write_cache_report(cout, cache);
+        }
+        if (window_predictor)
+        {
+            write_predictor_report(cout, predictor, *memory.program);
+        }
+    }
+}
+
+SampleEstimate estimate_total(const vector<double>& rates, const long long num_instructions)
+{
+    SampleEstimate estimate;
+    int num_windows = rates.size();
+    if (num_windows == 0)
+    {
+        return estimate;
+    }
+
+    double sum = 0;
+    for (double rate : rates)
+    {
+        sum += rate;
+    }
+    estimate.per_instruction = sum / num_windows;
+    estimate.total = estimate.per_instruction * num_instructions;
+
+    if (num_windows > 1)
+    {
+        double squares = 0;
+        for (double rate : rates)
+        {
+            squares += (rate - estimate.per_instruction) * (rate - estimate.per_instruction);
+        }
+        double standard_error = std::sqrt(squares / (num_windows - 1) / num_windows);
+        estimate.margin = CONFIDENCE_Z * standard_error * num_instructions;
+    }
+    return estimate;
+}
+
+void write_sample_report(std::ostream& out, const vector<SampleWindow>& windows, const long long num_instructions, const Options& options)
+{
+    const PipelineConfig& config = *options.pipeline;
+
+    out << "Sampled " << windows.size() << " windows of " << options.sample_window << " instructions every " << options.sample_every;
+    out << " (after " << options.sample_warmup << " warm-up) on the " << config.name << " stage pipeline" << endl;
+    out << "Instructions executed: " << num_instructions << endl;
+    if (windows.empty())
+    {
+        out << "ERROR: the program ended before the first window was measured!" << endl;
+        return;
+    }
+
+    vector<double> cycle_rates;
+    for (const SampleWindow& window : windows)
+    {
+        cycle_rates.push_back((double)window.num_cycles / window.num_instructions);
+    }
+    SampleEstimate cycles = estimate_total(cycle_rates, num_instructions);
+
+    out << std::fixed << std::setprecision(0);
+    out << "Estimated cycles: " << cycles.total << " +- " << cycles.margin << " (95% confidence)" << endl;
+    out << std::setprecision(4);
+    out << "Estimated CPI: " << cycles.per_instruction << " +- " << cycles.margin / num_instructions << endl;
+
+    out << "Estimated stall cycles per stage:" << endl;
+    out << std::setprecision(0);
+    for (Stage ii = 0; ii < config.num_stages; ii++)
+    {
+        vector<double> stall_rates;
+        for (const SampleWindow& window : windows)
+        {
+            stall_rates.push_back((double)window.stall_cycles[ii] / window.num_instructions);
+        }
+        SampleEstimate stalls = estimate_total(stall_rates, num_instructions);
+        out << "    " << std::left << setw(4) << config.stage_names[ii] << std::right << setw(16) << stalls.total << " +- " << stalls.margin << endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
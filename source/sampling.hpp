@@ -0,0 +1,37 @@
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "memory.hpp"
+#include "options.hpp"
+#include "stage.hpp"
+
+const double CONFIDENCE_Z = 1.96; // 95% two sided, normal approximation over the windows
+
+// what the pipeline did over the measured part of one sample window
+struct SampleWindow {
+    long long num_instructions = 0; // measured instructions, the warm-up ones before them are not counted
+    long long num_cycles = 0; // from the last warm-up instruction retiring to the last measured one retiring
+    long long stall_cycles[MAX_STAGES] = {}; // cycles an instruction sat in the stage past its latency
+};
+
+// a per instruction rate measured over every window, scaled up to the whole program
+struct SampleEstimate {
+    double per_instruction = 0; // mean over the windows
+    double total = 0; // per_instruction times the instructions executed
+    double margin = 0; // half width of the confidence interval of total, 0 with fewer than two windows
+};
+
+// runs the program functionally, timing a window of the pipeline every options.sample_every instructions
+// writes the extrapolated cycle and stall counts to the output file instead of the cycle table
+void run_sampled(Memory& memory, const Options& options, const std::string& output_file);
+
+// mean of one rate per window and its confidence interval, scaled to num_instructions
+SampleEstimate estimate_total(const std::vector<double>& rates, const long long num_instructions);
+
+// report of every estimate, written to the output file and echoed to the console
+void write_sample_report(std::ostream& out, const std::vector<SampleWindow>& windows, const long long num_instructions, const Options& options);
+
+#endif
@@ -1,13 +1,53 @@
 #ifndef STAGE_HPP
 #define STAGE_HPP
 
+#include <cstdint>
 #include <string>
 
-const int NUM_STAGES = 7;
-const int NUM_STAGE_REGS = NUM_STAGES - 1;
-const int NUM_MEM_CYCLES = 3;
+const int MAX_STAGES = 9; // deepest configuration below
 
-enum Stage {IF = 0, ID = 1, EX1 = 2, EX2 = 3, EX3 = 4, MEM = 5, WB = 6};
-const Stage stages[NUM_STAGES] = {IF, ID, EX1, EX2, EX3, MEM, WB};
+// stages are numbered by their position in a PipelineConfig
+// every configuration starts with IF, ID and EX1, the stages after them move with its depth
+typedef int Stage;
+const Stage IF = 0;
+const Stage ID = 1;
+const Stage EX1 = 2;
+
+// bit for a stage in a stage mask
+inline uint32_t stage_mask(const Stage stage)
+{
+    return 1u << stage;
+}
+
+// shape of the pipeline, IF and ID come first, then the execute stages, then MEM and WB
+// the timing loop is compiled once per configuration, so none of this is looked up while it runs
+struct PipelineConfig {
+    const char* name; // picked with --pipeline=
+    int num_stages;
+    int latencies[MAX_STAGES]; // cycles an instruction spends in each stage before it can move on
+    Stage branch_stage; // BEQ, BNE and J resolve here, nothing is fetched while one is between ID and here
+    Stage halt_stage; // HLT completes when it leaves this stage
+    const char* stage_names[MAX_STAGES];
+
+    constexpr Stage last_execute_stage() const { return num_stages - 3; }
+    constexpr Stage memory_stage() const { return num_stages - 2; }
+    constexpr Stage writeback_stage() const { return num_stages - 1; }
+};
+
+inline constexpr PipelineConfig FIVE_STAGE_PIPELINE = {
+    "5", 5, {1, 1, 1, 1, 1}, EX1, ID,
+    {"IF", "ID", "EX", "MEM", "WB"}};
+
+// the pipeline from the project documents
+inline constexpr PipelineConfig SEVEN_STAGE_PIPELINE = {
+    "7", 7, {1, 1, 1, 1, 1, 3, 1}, EX1, ID,
+    {"IF", "ID", "EX1", "EX2", "EX3", "MEM", "WB"}};
+
+// deeper execute stages resolve branches one stage later
+inline constexpr PipelineConfig NINE_STAGE_PIPELINE = {
+    "9", 9, {1, 1, 1, 1, 1, 1, 1, 3, 1}, EX1 + 1, ID,
+    {"IF", "ID", "EX1", "EX2", "EX3", "EX4", "EX5", "MEM", "WB"}};
+
+inline constexpr const PipelineConfig* DEFAULT_PIPELINE = &SEVEN_STAGE_PIPELINE;
 
 #endif
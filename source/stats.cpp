@@ -0,0 +1,177 @@
+#include <fstream>
+#include <iostream>
+#include "stats.hpp"
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::string;
+
+void start_stats(PipelineStats& stats, const int num_lines)
+{
+    stats = PipelineStats();
+    stats.lines.assign(num_lines, LineStats());
+}
+
+static double ratio(const long long numerator, const long long denominator)
+{
+    return denominator == 0 ? 0.0 : (double)numerator / denominator;
+}
+
+// the line as written in the program, quoted for a JSON string
+static void write_json_string(std::ostream& out, const string& text)
+{
+    out << '"';
+    for (char character : text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            out << '\\' << character;
+        }
+        else if (character == '\t')
+        {
+            out << "\\t";
+        }
+        else if ((unsigned char)character >= ' ')
+        {
+            out << character;
+        }
+    }
+    out << '"';
+}
+
+// the line as written in the program, quoted for a CSV field
+static void write_csv_string(std::ostream& out, const string& text)
+{
+    out << '"';
+    for (char character : text)
+    {
+        if (character == '"')
+        {
+            out << '"';
+        }
+        out << character;
+    }
+    out << '"';
+}
+
+static void write_json_stalls(std::ostream& out, const long long* stalls)
+{
+    out << "{";
+    for (int ii = 0; ii < NUM_STALL_REASONS; ii++)
+    {
+        out << (ii == 0 ? "" : ", ") << '"' << STALL_REASON_NAMES[ii] << "\": " << stalls[ii];
+    }
+    out << "}";
+}
+
+static void write_json(std::ostream& out, const PipelineStats& stats, const PipelineConfig& config, const Program& program)
+{
+    out << "{" << endl;
+    out << "  \"pipeline\": \"" << config.name << "\"," << endl;
+    out << "  \"cycles\": " << stats.num_cycles << "," << endl;
+    out << "  \"instructions\": " << stats.num_retired << "," << endl;
+    out << "  \"cpi\": " << ratio(stats.num_cycles, stats.num_retired) << "," << endl;
+    out << "  \"ipc\": " << ratio(stats.num_retired, stats.num_cycles) << "," << endl;
+
+    out << "  \"stages\": [" << endl;
+    for (Stage ii = 0; ii < config.num_stages; ii++)
+    {
+        const StageStats& stage = stats.stages[ii];
+        out << "    {\"name\": \"" << config.stage_names[ii] << "\", \"occupied\": " << stage.occupied
+            << ", \"utilisation\": " << ratio(stage.occupied, stats.num_cycles) << ", \"stalls\": ";
+        write_json_stalls(out, stage.stalls);
+        out << "}" << (ii + 1 < config.num_stages ? "," : "") << endl;
+    }
+    out << "  ]," << endl;
+
+    // only the lines that retired or stalled something, in program order
+    out << "  \"lines\": [";
+    bool first = true;
+    for (unsigned int ii = 0; ii < stats.lines.size(); ii++)
+    {
+        const LineStats& line = stats.lines[ii];
+        long long num_stalls = 0;
+        for (int jj = 0; jj < NUM_STALL_REASONS; jj++)
+        {
+            num_stalls += line.stalls[jj];
+        }
+        if (line.retired == 0 && num_stalls == 0)
+        {
+            continue;
+        }
+        out << (first ? "" : ",") << endl;
+        first = false;
+
+        out << "    {\"line\": " << ii + 1 << ", \"instruction\": ";
+        write_json_string(out, ii < program.original_lines.size() ? program.original_lines[ii] : "");
+        out << ", \"retired\": " << line.retired << ", \"stalls\": ";
+        write_json_stalls(out, line.stalls);
+        out << "}";
+    }
+    out << endl << "  ]" << endl;
+    out << "}" << endl;
+}
+
+static void write_csv(std::ostream& out, const PipelineStats& stats, const PipelineConfig& config, const Program& program)
+{
+    out << "scope,name,count,share";
+    for (int ii = 0; ii < NUM_STALL_REASONS; ii++)
+    {
+        out << "," << STALL_REASON_NAMES[ii];
+    }
+    out << ",instruction" << endl;
+
+    // run rows keep their value in count (cycles, instructions) or share (CPI, IPC)
+    out << "run,cycles," << stats.num_cycles << ",,,,,," << endl;
+    out << "run,instructions," << stats.num_retired << ",,,,,," << endl;
+    out << "run,cpi,," << ratio(stats.num_cycles, stats.num_retired) << ",,,,," << endl;
+    out << "run,ipc,," << ratio(stats.num_retired, stats.num_cycles) << ",,,,," << endl;
+
+    // stage rows count the cycles the stage was occupied and its share of the run
+    for (Stage ii = 0; ii < config.num_stages; ii++)
+    {
+        const StageStats& stage = stats.stages[ii];
+        out << "stage," << config.stage_names[ii] << "," << stage.occupied << "," << ratio(stage.occupied, stats.num_cycles);
+        for (int jj = 0; jj < NUM_STALL_REASONS; jj++)
+        {
+            out << "," << stage.stalls[jj];
+        }
+        out << "," << endl;
+    }
+
+    // line rows count how many times the line retired
+    for (unsigned int ii = 0; ii < stats.lines.size(); ii++)
+    {
+        const LineStats& line = stats.lines[ii];
+        out << "line," << ii + 1 << "," << line.retired << ",";
+        for (int jj = 0; jj < NUM_STALL_REASONS; jj++)
+        {
+            out << "," << line.stalls[jj];
+        }
+        out << ",";
+        write_csv_string(out, ii < program.original_lines.size() ? program.original_lines[ii] : "");
+        out << endl;
+    }
+}
+
+bool write_stats(const string& filename, const PipelineStats& stats, const PipelineConfig& config, const Program& program)
+{
+    ofstream file;
+    file.open(filename, ofstream::trunc);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    if (filename.ends_with(CSV_EXTENSION))
+    {
+        write_csv(file, stats, config, program);
+    }
+    else
+    {
+        write_json(file, stats, config, program);
+    }
+    file.close();
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <string>
+#include <vector>
+#include "program.hpp"
+#include "stage.hpp"
+
+const std::string CSV_EXTENSION = ".csv"; // --stats-out= writes CSV to a file ending in this, JSON to anything else
+
+// why a cycle was lost, to a stage holding an instruction past its latency or to IF sitting empty
+// STALL_STRUCTURAL: the stage ahead was still full
+// STALL_DATA: a source register was waiting on an older instruction (data_hazard_exists())
+// STALL_CONTROL: IF could not fetch past an unresolved branch or jump
+// STALL_MEMORY: the stage ahead was full because MEM was still busy with an access
+enum StallReason {STALL_STRUCTURAL = 0, STALL_DATA, STALL_CONTROL, STALL_MEMORY, NUM_STALL_REASONS};
+const char* const STALL_REASON_NAMES[] = {"structural", "data", "control", "memory"};
+
+struct StageStats {
+    long long occupied = 0; // cycles an instruction was in the stage, stalled or not
+    long long stalls[NUM_STALL_REASONS] = {};
+};
+
+// a line of the program over every time it ran, control stalls are charged to the branch that caused them
+struct LineStats {
+    long long retired = 0;
+    long long stalls[NUM_STALL_REASONS] = {};
+};
+
+// where the cycles of a timed run went, only kept when --stats-out= is given
+struct PipelineStats {
+    long long num_cycles = 0;
+    long long num_retired = 0;
+    StageStats stages[MAX_STAGES];
+    std::vector<LineStats> lines; // indexed by line number - 1
+};
+
+// sizes empty counters for a program of num_lines lines
+void start_stats(PipelineStats& stats, const int num_lines);
+
+// writes CPI, IPC, each stage's utilisation and stalls, and each line's stalls, as CSV or JSON by the file's extension
+bool write_stats(const std::string& filename, const PipelineStats& stats, const PipelineConfig& config, const Program& program);
+
+#endif
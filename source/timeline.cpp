@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "timeline.hpp"
+#include "utils.hpp"
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+// small deltas of either sign take a byte, most columns only ever step by a few cycles
+static void append_varint(string& out, const long long value)
+{
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (zigzag >= 0x80)
+    {
+        out += (char)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    out += (char)zigzag;
+}
+
+// false if the varint runs past end, or past the 10 bytes a 64 bit value can take
+static bool read_varint(const unsigned char*& bytes, const unsigned char* end, long long& value)
+{
+    uint64_t zigzag = 0;
+    for (int shift = 0; bytes < end && shift < 64; shift += 7)
+    {
+        unsigned char byte = *bytes++;
+        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+        if (not (byte & 0x80))
+        {
+            value = (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int num_columns(const uint32_t num_stages)
+{
+    return TIMELINE_STAGES + num_stages;
+}
+
+bool open_timeline_writer(TimelineWriter& writer, const string& filename, const PipelineConfig& config)
+{
+    writer.file.open(filename, ofstream::binary | ofstream::trunc);
+    if (not writer.file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    writer.header = TimelineHeader();
+    memcpy(writer.header.magic, TIMELINE_MAGIC, sizeof(TIMELINE_MAGIC));
+    writer.header.num_stages = config.num_stages;
+    strncpy(writer.header.pipeline_name, config.name, sizeof(writer.header.pipeline_name) - 1);
+    writer.blocks.clear();
+    writer.block = TimelineBlock();
+    writer.block.offset = sizeof(TimelineHeader);
+
+    // rewritten with the counts once the run is over
+    writer.file.write((const char*)&writer.header, sizeof(writer.header));
+    return true;
+}
+
+// writes out the columns of the block being filled and starts the next one after it
+static void finish_block(TimelineWriter& writer)
+{
+    TimelineBlock& block = writer.block;
+    uint64_t next_offset = block.offset;
+    for (int ii = 0; ii < num_columns(writer.header.num_stages); ii++)
+    {
+        writer.file.write(writer.columns[ii].data(), writer.columns[ii].size());
+        block.column_sizes[ii] = writer.columns[ii].size();
+        next_offset += writer.columns[ii].size();
+        writer.columns[ii].clear();
+        writer.previous[ii] = 0;
+    }
+    writer.blocks.push_back(block);
+    writer.header.num_rows += block.num_rows;
+
+    block = TimelineBlock();
+    block.offset = next_offset;
+    block.first_row = writer.header.num_rows;
+}
+
+void write_timeline_row(TimelineWriter& writer, const TimelineRow& row)
+{
+    TimelineBlock& block = writer.block;
+    long long values[TIMELINE_MAX_COLUMNS] = {row.instr_index, row.line_number, row.stalls};
+    std::copy(row.finish_log, row.finish_log + writer.header.num_stages, values + TIMELINE_STAGES);
+
+    if (block.num_rows == 0)
+    {
+        block.first_cycle = row.finish_log[IF];
+    }
+    for (int ii = 0; ii < num_columns(writer.header.num_stages); ii++)
+    {
+        append_varint(writer.columns[ii], values[ii] - writer.previous[ii]);
+        writer.previous[ii] = values[ii];
+    }
+    block.last_cycle = std::max<int64_t>(block.last_cycle, *std::max_element(row.finish_log, row.finish_log + writer.header.num_stages));
+
+    block.num_rows++;
+    if (block.num_rows == TIMELINE_BLOCK_ROWS)
+    {
+        finish_block(writer);
+    }
+}
+
+void close_timeline_writer(TimelineWriter& writer)
+{
+    if (writer.block.num_rows != 0)
+    {
+        finish_block(writer);
+    }
+
+    // the index is read in place once mapped, so it starts on an 8 byte boundary
+    uint64_t index_offset = (writer.block.offset + 7) / 8 * 8;
+    const char PADDING[8] = {};
+    writer.file.write(PADDING, index_offset - writer.block.offset);
+    writer.file.write((const char*)writer.blocks.data(), writer.blocks.size() * sizeof(TimelineBlock));
+
+    writer.header.num_blocks = writer.blocks.size();
+    writer.header.index_offset = index_offset;
+    writer.file.seekp(0);
+    writer.file.write((const char*)&writer.header, sizeof(writer.header));
+    writer.file.close();
+}
+
+bool open_timeline(TimelineFile& timeline, const string& filename)
+{
+    timeline.mapped = map_file(filename);
+    if (not timeline.mapped.is_open)
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    // make sure the file was written by this version of the simulator and finished
+    const TimelineHeader* header = (const TimelineHeader*)timeline.mapped.begin;
+    bool valid = timeline.mapped.size >= sizeof(TimelineHeader) && memcmp(header->magic, TIMELINE_MAGIC, sizeof(TIMELINE_MAGIC)) == 0
+        && header->version == TIMELINE_VERSION && header->num_stages <= MAX_STAGES && header->index_offset % 8 == 0
+        && header->index_offset <= timeline.mapped.size && header->num_blocks <= (timeline.mapped.size - header->index_offset) / sizeof(TimelineBlock);
+    timeline.config = valid ? find_pipeline_config(string(header->pipeline_name, strnlen(header->pipeline_name, sizeof(header->pipeline_name)))) : nullptr;
+    if (not valid || not timeline.config || (uint32_t)timeline.config->num_stages != header->num_stages)
+    {
+        cout << "ERROR: " << filename << " is not a timeline written by this simulator!" << endl;
+        unmap_file(timeline.mapped);
+        return false;
+    }
+
+    timeline.header = header;
+    timeline.blocks = (const TimelineBlock*)(timeline.mapped.begin + header->index_offset);
+
+    // every block's columns must lie between the header and the index, and hold no more rows than the writer puts in one
+    for (uint64_t ii = 0; ii < header->num_blocks; ii++)
+    {
+        const TimelineBlock& block = timeline.blocks[ii];
+        uint64_t end = block.offset;
+        for (int jj = 0; jj < num_columns(header->num_stages); jj++)
+        {
+            end += block.column_sizes[jj];
+        }
+        if (block.offset < sizeof(TimelineHeader) || block.offset > header->index_offset || end > header->index_offset
+            || block.num_rows > TIMELINE_BLOCK_ROWS)
+        {
+            cout << "ERROR: " << filename << " is not a timeline written by this simulator!" << endl;
+            close_timeline(timeline);
+            return false;
+        }
+    }
+    return true;
+}
+
+void close_timeline(TimelineFile& timeline)
+{
+    unmap_file(timeline.mapped);
+    timeline.header = nullptr;
+    timeline.blocks = nullptr;
+}
+
+bool read_timeline_block(const TimelineFile& timeline, const uint64_t block_number, vector<TimelineRow>& rows)
+{
+    const TimelineBlock& block = timeline.blocks[block_number];
+    rows.assign(block.num_rows, TimelineRow());
+
+    // each column is decoded on its own, it is a run of deltas from the row before that fills its bytes exactly
+    const unsigned char* column = (const unsigned char*)timeline.mapped.begin + block.offset;
+    for (int ii = 0; ii < num_columns(timeline.header->num_stages); ii++)
+    {
+        const unsigned char* bytes = column;
+        const unsigned char* end = column + block.column_sizes[ii];
+        long long value = 0;
+        for (TimelineRow& row : rows)
+        {
+            long long delta = 0;
+            if (not read_varint(bytes, end, delta))
+            {
+                return false;
+            }
+            value = (long long)((uint64_t)value + (uint64_t)delta);
+            switch (ii)
+            {
+            case TIMELINE_INDEX:
+                row.instr_index = value;
+                break;
+            case TIMELINE_LINE:
+                row.line_number = value;
+                break;
+            case TIMELINE_STALLS:
+                row.stalls = value;
+                break;
+            default:
+                row.finish_log[ii - TIMELINE_STAGES] = value;
+                break;
+            }
+        }
+        if (bytes != end)
+        {
+            return false;
+        }
+        column = end;
+    }
+    return true;
+}
+
+uint64_t find_timeline_row(const TimelineFile& timeline, const uint64_t first_row)
+{
+    const TimelineBlock* end = timeline.blocks + timeline.header->num_blocks;
+    const TimelineBlock* after = std::upper_bound(timeline.blocks, end, first_row,
+        [](const uint64_t row, const TimelineBlock& block) { return row < block.first_row; });
+    return after == timeline.blocks ? 0 : after - timeline.blocks - 1;
+}
+
+// rows still in flight at the end finish nothing after IF, so last_cycle is only in order up to them and the index is scanned
+uint64_t find_timeline_cycle(const TimelineFile& timeline, const long long first_cycle)
+{
+    for (uint64_t ii = 0; ii < timeline.header->num_blocks; ii++)
+    {
+        if (timeline.blocks[ii].last_cycle >= first_cycle)
+        {
+            return ii;
+        }
+    }
+    return timeline.header->num_blocks;
+}
@@ -0,0 +1,82 @@
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+#include "stage.hpp"
+
+const int TIMELINE_VERSION = 1;
+const char TIMELINE_MAGIC[8] = "MIPSTLN";
+const int TIMELINE_BLOCK_ROWS = 1 << 16; // rows per block, a range query decodes whole blocks
+
+// columns of every block, in the order they are stored, TIMELINE_STAGES is followed by one per stage
+enum TimelineColumn {TIMELINE_INDEX = 0, TIMELINE_LINE, TIMELINE_STALLS, TIMELINE_STAGES};
+const int TIMELINE_MAX_COLUMNS = TIMELINE_STAGES + MAX_STAGES;
+
+// one instruction of a timed run, in the order they were fetched
+struct TimelineRow {
+    long long instr_index = 0; // Instruction::instr_index
+    int line_number = 0;
+    long long stalls = 0; // cycles spent in ID onwards beyond each stage's latency
+    long long finish_log[MAX_STAGES] = {}; // 0 for stages an instruction still in flight never finished
+};
+
+// start of a timeline file, the blocks follow it and the index of blocks comes last
+struct TimelineHeader {
+    char magic[8] = {};
+    uint32_t version = TIMELINE_VERSION;
+    uint32_t num_stages = 0;
+    char pipeline_name[8] = {}; // PipelineConfig::name, gives the stage names back
+    uint64_t num_rows = 0;
+    uint64_t num_blocks = 0;
+    uint64_t index_offset = 0; // where the TimelineBlock of every block starts, 8 byte aligned
+};
+
+// where a block is and what it covers, each column is zigzag varint deltas from the row before, starting from 0
+struct TimelineBlock {
+    uint64_t offset = 0;
+    uint64_t first_row = 0;
+    int64_t first_cycle = 0; // IF finish of its first row, rows are in fetch order so this only grows
+    int64_t last_cycle = 0; // latest finish of any stage of its rows
+    uint32_t num_rows = 0;
+    uint32_t column_sizes[TIMELINE_MAX_COLUMNS] = {};
+};
+
+// streams rows into blocks as a run retires them, only one block is held in memory
+struct TimelineWriter {
+    std::ofstream file;
+    TimelineHeader header;
+    TimelineBlock block; // the one being filled
+    std::vector<TimelineBlock> blocks;
+    std::string columns[TIMELINE_MAX_COLUMNS];
+    long long previous[TIMELINE_MAX_COLUMNS] = {};
+};
+
+bool open_timeline_writer(TimelineWriter& writer, const std::string& filename, const PipelineConfig& config);
+void write_timeline_row(TimelineWriter& writer, const TimelineRow& row);
+
+// writes the last block and the index, the file cannot be read before this
+void close_timeline_writer(TimelineWriter& writer);
+
+// a timeline file mapped for reading, header and blocks point into the mapping
+struct TimelineFile {
+    MappedFile mapped;
+    const TimelineHeader* header = nullptr;
+    const TimelineBlock* blocks = nullptr;
+    const PipelineConfig* config = nullptr;
+};
+
+bool open_timeline(TimelineFile& timeline, const std::string& filename);
+void close_timeline(TimelineFile& timeline);
+
+// decodes every row of a block, replacing what was in rows, false if a column does not hold exactly num_rows values
+bool read_timeline_block(const TimelineFile& timeline, const uint64_t block, std::vector<TimelineRow>& rows);
+
+// first block holding a row at or after first_row, or that ends at or after first_cycle, num_blocks if none does
+uint64_t find_timeline_row(const TimelineFile& timeline, const uint64_t first_row);
+uint64_t find_timeline_cycle(const TimelineFile& timeline, const long long first_cycle);
+
+#endif
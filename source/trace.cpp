@@ -0,0 +1,188 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "trace.hpp"
+#include "functional.hpp"
+#include "memory.hpp"
+#include "mapped_file.hpp"
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+void open_live_source(TraceSource& source, FunctionalState& functional, Memory& memory)
+{
+    source.buffer.resize(TRACE_BUFFER_RECORDS);
+    source.num_buffered = 0;
+    source.next = 0;
+    source.functional = &functional;
+    source.memory = &memory;
+}
+
+bool open_trace_file(TraceSource& source, const string& filename, const Program& program)
+{
+    source.buffer.resize(TRACE_BUFFER_RECORDS);
+    source.num_buffered = 0;
+    source.next = 0;
+    source.functional = nullptr;
+    source.memory = nullptr;
+    source.num_lines = program.instructions.size();
+
+    source.file.open(filename, ifstream::binary);
+    if (not source.file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return false;
+    }
+
+    // make sure the file was written by this version of the simulator
+    TraceHeader header;
+    source.file.read((char*)&header, sizeof(header));
+    if (not source.file || memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord))
+    {
+        cout << "ERROR: " << filename << " is not a trace written by this simulator!" << endl;
+        source.file.close();
+        return false;
+    }
+    if (header.program_hash != hash_program(program))
+    {
+        cout << "ERROR: " << filename << " was traced from a different program!" << endl;
+        source.file.close();
+        return false;
+    }
+    return true;
+}
+
+// the source ends once the records have all been fetched, since it has nowhere to refill from
+void open_record_source(TraceSource& source, const TraceRecord* records, const int num_records)
+{
+    source.buffer.assign(records, records + num_records);
+    source.num_buffered = num_records;
+    source.next = 0;
+    source.functional = nullptr;
+    source.memory = nullptr;
+}
+
+// refills the buffer from wherever the source gets its records
+void refill_source(TraceSource& source)
+{
+    source.next = 0;
+    if (source.functional)
+    {
+        source.num_buffered = step_functional(*source.functional, *source.memory, source.buffer.data(), source.buffer.size());
+    }
+    else if (source.file.is_open())
+    {
+        source.file.read((char*)source.buffer.data(), source.buffer.size() * sizeof(TraceRecord));
+        source.num_buffered = source.file.gcount() / sizeof(TraceRecord);
+
+        // a damaged record ends the trace where it is, the run stops as if the program had
+        for (int ii = 0; ii < source.num_buffered; ii++)
+        {
+            if (not valid_record(source.buffer[ii], source.num_lines))
+            {
+                cout << "ERROR: the trace has a record that is not from this program!" << endl;
+                source.num_buffered = ii;
+                source.file.close();
+                break;
+            }
+        }
+    }
+    else
+    {
+        source.num_buffered = 0;
+    }
+}
+
+bool next_record(TraceSource& source, TraceRecord& record)
+{
+    if (source.next == source.num_buffered)
+    {
+        refill_source(source);
+        if (source.num_buffered == 0)
+        {
+            return false;
+        }
+    }
+    record = source.buffer[source.next++];
+    return true;
+}
+
+long long write_trace(Memory& memory, const string& filename)
+{
+    ofstream file;
+    file.open(filename, ofstream::binary | ofstream::trunc);
+    if (not file.is_open())
+    {
+        cout << "File could not be opened!" << endl;
+        return 0;
+    }
+
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.program_hash = hash_program(*memory.program);
+    file.write((const char*)&header, sizeof(header));
+
+    // run the program one buffer at a time so the trace never has to fit in memory
+    FunctionalState functional;
+    start_functional(functional, memory);
+    vector<TraceRecord> buffer = vector<TraceRecord>(TRACE_BUFFER_RECORDS);
+    long long num_records = 0;
+    int num_buffered;
+    do
+    {
+        num_buffered = step_functional(functional, memory, buffer.data(), buffer.size());
+        file.write((const char*)buffer.data(), num_buffered * sizeof(TraceRecord));
+        num_records += num_buffered;
+    } while (num_buffered == (int)buffer.size());
+
+    finish_functional(functional, memory);
+    file.close();
+    return num_records;
+}
+
+static bool valid_register(const int reg)
+{
+    return reg >= NO_REG && reg < NUM_REGS;
+}
+
+bool valid_record(const TraceRecord& record, const int num_lines)
+{
+    return record.opcode <= HLT && valid_register(record.result_reg) && valid_register(record.source_reg1)
+        && valid_register(record.source_reg2) && record.line_number >= 1 && record.line_number <= num_lines;
+}
+
+uint64_t hash_program(const Program& program)
+{
+    string text;
+    for (const string& line : program.original_lines)
+    {
+        text += line;
+        text += '\n';
+    }
+    return hash_bytes(text.data(), text.size());
+}
+
+Instruction instruction_from_record(const TraceRecord& record)
+{
+    Instruction instruction;
+    instruction.line_number = record.line_number;
+    instruction.opcode = (OPCODE)record.opcode;
+    instruction.result_reg = record.result_reg;
+    instruction.source_reg1 = record.source_reg1;
+    instruction.source_reg2 = record.source_reg2;
+    instruction.address = record.address;
+    instruction.branch_taken = record.taken;
+
+    // same flags the parser derives from the opcode
+    instruction.writes_to_register = instruction.result_reg != NO_REG;
+    instruction.has_source_regs = instruction.source_reg1 != NO_REG || instruction.source_reg2 != NO_REG;
+    instruction.source_mask = register_mask(instruction.source_reg1) | register_mask(instruction.source_reg2);
+    instruction.is_branch = instruction.opcode == BEQ || instruction.opcode == BNE;
+    instruction.exists = true;
+    return instruction;
+}
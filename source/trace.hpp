@@ -0,0 +1,75 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "instruction.hpp"
+#include "program.hpp"
+
+const int TRACE_VERSION = 2;
+const int TRACE_BUFFER_RECORDS = 1 << 16; // records moved to/from disk at a time
+const char TRACE_MAGIC[8] = "MIPSTRC";
+
+// one executed instruction, everything the timing model needs to place it in the pipeline
+struct TraceRecord {
+    int32_t line_number = 0; // line the instruction came from (its PC + 1)
+    int32_t address = 0; // data address read by LW or written by SW, 0 otherwise
+    uint8_t opcode = NOP;
+    int8_t result_reg = NO_REG;
+    int8_t source_reg1 = NO_REG;
+    int8_t source_reg2 = NO_REG;
+    uint8_t taken = 0; // 1 if a branch was taken or a jump executed
+    uint8_t padding[3] = {};
+};
+
+// written once at the start of a trace file
+struct TraceHeader {
+    char magic[8] = {};
+    uint32_t version = TRACE_VERSION;
+    uint32_t record_size = sizeof(TraceRecord);
+    uint64_t program_hash = 0; // hash_program() of the program traced, a trace only replays against the same one
+};
+
+struct FunctionalState;
+struct Memory;
+
+// where the timing model gets its stream of executed instructions from
+// either the functional engine running alongside it, a trace file written earlier, or records handed over up front
+struct TraceSource {
+    std::vector<TraceRecord> buffer;
+    int num_buffered = 0;
+    int next = 0;
+
+    // live source
+    FunctionalState* functional = nullptr;
+    Memory* memory = nullptr;
+
+    // file source
+    std::ifstream file;
+    int num_lines = 0; // lines of the program being replayed, records naming any other line are rejected
+};
+
+// opening sources
+void open_live_source(TraceSource& source, FunctionalState& functional, Memory& memory);
+bool open_trace_file(TraceSource& source, const std::string& filename, const Program& program);
+void open_record_source(TraceSource& source, const TraceRecord* records, const int num_records);
+
+// pulls the next executed instruction, returns false once the program has ended
+bool next_record(TraceSource& source, TraceRecord& record);
+
+// runs the program functionally and streams its trace to a file, returns the number of records written
+long long write_trace(Memory& memory, const std::string& filename);
+
+// rebuilds the dynamic instruction the pipeline works on from a record
+Instruction instruction_from_record(const TraceRecord& record);
+
+// true if the record's opcode is known, its registers exist and its line is one of num_lines
+// records read back from a file are checked before instruction_from_record() turns registers into scoreboard bits
+bool valid_record(const TraceRecord& record, const int num_lines);
+
+// hash of every line of a program as written, a trace or checkpoint only replays the program it was taken of
+uint64_t hash_program(const Program& program);
+
+#endif
@@ -1,108 +1,35 @@
+#include <algorithm>
+#include <charconv>
+#include <climits>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <regex>
 #include "utils.hpp"
 #include "memory.hpp"
+#include "functional.hpp"
+#include "trace.hpp"
+#include "lexer.hpp"
+#include "cache.hpp"
+#include "predictor.hpp"
+#include "checkpoint.hpp"
+#include "stats.hpp"
+#include "output.hpp"
+#include "timeline.hpp"
 using std::bitset;
 using std::cout;
 using std::endl;
 using std::fstream;
 using std::ofstream;
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::vector;
 
-extern const bool ENABLE_UNLIMITED_INPUT;
-extern const int OPTIONAL_CYCLE_LIMIT;
-extern const int MAX_CYCLE_LIMIT;
 const string WHITESPACE = " \n\t\r\f\v";    // for trimming whitespace (might use isspace() instead)
-const int NUM_PAD_SPACES = 35;
-
-// fills instruction memory from input file
-void load_program(Program& program, const string& filename)
-{
-    string line;
-    fstream file;
-    int num_instrs = 0;
-
-    // load each instruction into memory, line by line
-    file.open(filename);
-    if (file.is_open())
-    {
-
-        // count lines so we can presize instruction vector
-        while (!file.eof())
-        {
-            file.ignore(256, '\n');
-            num_instrs++;
-        }
-        program.instructions.resize(num_instrs);
-
-        // go back to the start of file
-        file.seekg(0);
-
-        // parse each line
-        for (int ii = 0; ii < num_instrs; ii++)
-        {
-            getline(file, line);
-            read_instruction_line(program.instructions[ii], line, ii + 1);
-        }
-        file.close();
-
-        fill_label_map(program);
-    }
-    else
-    {
-        cout << "File could not be opened!" << endl;
-    }
-}
-
-// completely parses a single instruction
-void read_instruction_line(Instruction& instruction, string& line, const int line_number)
-{
-    // clean up line
-    remove_bars(line);
-    remove_CR_and_LF(line);
-
-    // store trivial variables
-    instruction.line_number = line_number;
-    instruction.original_line = line;
-
-    // standardize line to be like native MIPS
-    trim_line(line);
-    make_uppercase(line);
-
-    // parse rest of instruction member variables
-    extract_label(instruction, line);
-    extract_opcode(instruction, line);
-    extract_arguments(instruction, line);
-}
-
-// gets rid of "|" so that accepted input can still slightly resemble native MIPS
-void remove_bars(string& line)
-{
-    for (unsigned int ii = 0; ii < line.length(); ii++)
-    {
-        if (line[ii] == '|')
-        {
-            line.erase(ii, 1);
-            ii--;
-        }
-    }
-}
-
-void remove_CR_and_LF(std::string& line)
-{
-    for (unsigned int ii = 0; ii < line.length(); ii++)
-    {
-        if (line[ii] == '\n' || line[ii] == '\r')
-        {
-            line.replace(ii, 1, " ");
-        }
-    }
-}
+const long long NO_EVENT = LLONG_MAX; // no upcoming cycle is known to differ from the current one
 
 // removes leading and trailing whitespaces of given string to aid parsing
 void trim_line(string& line)
@@ -114,773 +41,1091 @@ void trim_line(string& line)
         int first_non_whitespace = line.find_first_not_of(WHITESPACE);
         int last_non_whitespace = line.find_last_not_of(WHITESPACE);
 
+        // line is nothing but whitespace
+        if (first_non_whitespace == -1)
+        {
+            line.clear();
+            return;
+        }
+
         // trim line being parsed
         line = line.substr(first_non_whitespace, last_non_whitespace - first_non_whitespace + 1);
     }
 }
 
-// makes every alphabetical character uppercase to remove case sensitivity
-void make_uppercase(string& line)
+// put labels into hashmap, line numbers are not stored since resolve_label() accepts them directly
+void fill_label_map(Program& program, const vector<InstructionText>& texts)
 {
-    for (unsigned int ii = 0; ii < line.length(); ii++)
+    program.labels.reserve(std::count_if(texts.begin(), texts.end(), [](const InstructionText& text) { return not text.label.empty(); }));
+    for (unsigned int ii = 0; ii < program.instructions.size(); ii++)
     {
-        line[ii] = toupper(line[ii]);
+        const string_view label = texts[ii].label;
+        if (not label.empty())
+        {
+            program.labels.insert({string(label), program.instructions[ii].line_number});
+        }
     }
 }
 
-// parses label without using "|"
-void extract_label(Instruction& instruction, string& line)
+// turns the text operands of an instruction into register indices, immediates and branch targets
+// run once every label is in the label map, the pipeline only ever looks at the decoded form
+void decode_instruction(Instruction& instruction, const InstructionText& text, const std::unordered_map<std::string, int>& labels)
 {
-    int pos = line.find(':');
-    if (pos != -1)
-    {    // label exists
-
-        // store label and remove from line being parsed
-        instruction.label = line.substr(0, pos);
-        line.erase(0, pos + 1);
-        trim_line(line);
-    }
-    else
-    {    // label does not exist
-        instruction.label = "";
+    if (not instruction.exists)
+    {
+        return;
     }
-}
 
-// parses opcode without using "|"
-void extract_opcode(Instruction& instruction, string& line)
-{
-    if (line.empty())
+    // the lexer leaves the opcode as NOP when the line does not start with a valid one
+    if (instruction.opcode == NOP)
     {
-        instruction.opcode = "";
-        // instruction.is_empty = true;
+        cout << "ERROR: invalid opcode on line " << instruction.line_number << "!" << endl;
         instruction.exists = false;
+        return;
     }
-    else
-    {
-        instruction.exists = true;
-    }
-
-    unsigned int cur_length = 0;
-    string cur_op = "";
-    string next_op = "";
-    bool cur_valid;
-    bool next_valid;
-
-    // keep widening search until cur is valid, but next is invalid
-    do
-    {
-        // get potential opcodes
-        cur_op = line.substr(0, cur_length);
-        if (cur_length + 1 <= line.length())
-        {
-            next_op = line.substr(0, cur_length + 1);
-        }
 
-        // check if potential opcodes are valid
-        cur_valid = VALID_OPCODES.contains(cur_op);
-        next_valid = VALID_OPCODES.contains(next_op);
-        cur_length++;
-
-    } while ((cur_valid == false || next_valid == true) && cur_length <= line.length());
-
-    // store opcode and remove from line being parsed
-    instruction.opcode = cur_op;
-    line.erase(0, cur_length - 1);
-    trim_line(line);
-}
-
-// assigns {arg1, arg2, arg3} for each instruction given its comma seperated operands
-void extract_arguments(Instruction& instruction, string& line)
-{
-    string arg1 = extract_next_argument(line);
-    string arg2 = extract_next_argument(line);
-    string arg3 = extract_next_argument(line);
-    instruction.arg1 = arg1;
-    instruction.arg2 = arg2;
-    instruction.arg3 = arg3;
-
-    int opcode = VALID_OPCODES.at(instruction.opcode);
-    switch (opcode)
+    switch (instruction.opcode)
     {
     case LW:    // {rd, #(rs)}
-        instruction.result_reg = arg1;
-        instruction.source_reg1 = get_register_from_address(arg2);
+        instruction.result_reg = register_index(text.arg1);
+        decode_address(text.arg2, instruction.source_reg1, instruction.immediate);
         instruction.writes_to_register = true;
         instruction.has_source_regs = true;
         break;
 
     case SW:    // {rs, #(rt)}
-        instruction.source_reg1 = arg1;
-        instruction.source_reg2 = get_register_from_address(arg2);
+        instruction.source_reg1 = register_index(text.arg1);
+        decode_address(text.arg2, instruction.source_reg2, instruction.immediate);
         instruction.has_source_regs = true;
         break;
 
     case LI:    // {rd, #}
-        instruction.result_reg = arg1;
+        instruction.result_reg = register_index(text.arg1);
+        instruction.immediate = resolve_immediate(text.arg2);
         instruction.writes_to_register = true;
         break;
 
-    case ADD:     // {rd, rs, rt}
-    case MULT:    // {rd, rs, rt}
-    case SUB:     // {rd, rs, rt}
-        instruction.result_reg = arg1;
-        instruction.source_reg1 = arg2;
-        instruction.source_reg2 = arg3;
-        instruction.writes_to_register = true;
-        instruction.has_source_regs = true;
-        break;
-
+    case ADD:      // {rd, rs, rt}
+    case MULT:     // {rd, rs, rt}
+    case SUB:      // {rd, rs, rt}
     case ADDI:     // {rd, rs, #}
     case MULTI:    // {rd, rs, #}
     case SUBI:     // {rd, rs, #}
-        instruction.result_reg = arg1;
-        instruction.source_reg1 = arg2;
+        instruction.result_reg = register_index(text.arg1);
+        instruction.source_reg1 = register_index(text.arg2);
+
+        // either form accepts a register or an immediate as its last operand
+        if (parse_register(text.arg3) != NO_REG)
+        {
+            instruction.source_reg2 = register_index(text.arg3);
+        }
+        else
+        {
+            instruction.immediate = resolve_operand(labels, text.arg3);
+        }
         instruction.writes_to_register = true;
         instruction.has_source_regs = true;
         break;
 
     case BEQ:    // {rs, rt, label/#}
+        instruction.source_reg1 = register_index(text.arg1);
+        instruction.source_reg2 = register_index(text.arg2);
+        instruction.target = resolve_label(labels, text.arg3, instruction.line_number);
+        instruction.has_source_regs = true;
+        instruction.is_branch = true;
+        break;
+
     case BNE:    // {rs, rt, label/#}
-        instruction.source_reg1 = arg1;
-        instruction.source_reg2 = arg2;
+        instruction.source_reg1 = register_index(text.arg1);
+        instruction.source_reg2 = register_index(text.arg2);
+        instruction.target = resolve_label(labels, text.arg3, instruction.line_number) - 1;
         instruction.has_source_regs = true;
         instruction.is_branch = true;
         break;
 
-    case J:      // {label/#}
+    case J:    // {label/#}
+        instruction.target = resolve_label(labels, text.arg1, instruction.line_number) - 1;
+        break;
+
     case HLT:    // {}
+    case NOP:
         break;
     };
 }
 
-// extracts the next argument from comma seperated list of operands
-// returns empty string if all operands have already been extracted
-// use to generalise operations with the same number of operands
-string extract_next_argument(string& line)
+// splits an address like "#(rs)" or "rs(#)" into its register index and offset
+void decode_address(const string_view str, int& base_reg, int& offset)
 {
-    // remove spaces to widen scope of valid input (allows spaces in arg list)
-    trim_line(line);
+    size_t open_par_pos = str.find('(');
+    size_t close_par_pos = str.find(')');
+    string_view op1 = trim(str.substr(0, open_par_pos));
+    string_view op2 = trim(str.substr(open_par_pos + 1, close_par_pos - open_par_pos - 1));
 
-    string next_arg;
-    int comma_pos = line.find(',');
+    if (not str.starts_with('R'))
+    {    // op1 is immediate, op2 is register
+        offset = parse_number(op1, 10);
+        base_reg = register_index(op2);
+    }
+    else
+    {    // op1 is register, op2 is immediate
+        base_reg = register_index(op1);
+        offset = parse_number(op2, 10);
+    }
+}
 
-    if (line.empty())
+// returns the index of a register name like "R5", NO_REG if it is not one
+int parse_register(const string_view str)
+{
+    if (str.length() < 2 || str.length() > 3 || str[0] != 'R' || (str.length() == 3 && str[1] == '0'))
     {
-        return "";
-    }
-    else if (comma_pos != -1)
-    {    // comma exists (at least 2 arguments left)
-        next_arg = line.substr(0, comma_pos);
-        line.erase(0, comma_pos + 1);
-        return next_arg;
+        return NO_REG;
     }
-    else
-    {    // comma does not exist (only 1 argument left)
-        next_arg = line.substr(0, comma_pos);
-        line.erase(0, line.length());
-        return next_arg;
+
+    int index = 0;
+    for (size_t ii = 1; ii < str.length(); ii++)
+    {
+        if (str[ii] < '0' || str[ii] > '9')
+        {
+            return NO_REG;
+        }
+        index = index * 10 + (str[ii] - '0');
     }
+    return index < NUM_REGS ? index : NO_REG;
 }
 
-string get_register_from_address(const string& str)
+// converts a register name like "R5" into its index
+int register_index(const string_view str)
 {
-    string copy = str;
+    int index = parse_register(str);
+    if (index == NO_REG)
+    {
+        cout << "ERROR: invalid register \"" << str << "\"!" << endl;
+        return 0;
+    }
+    return index;
+}
 
-    int open_par_pos = str.find('(');
-    string op1 = str.substr(0, open_par_pos);
+// gets the line number of a label, line numbers can also be used as labels
+int resolve_label(const std::unordered_map<std::string, int>& labels, const string_view str, const int line_number)
+{
+    auto label = labels.find(string(str));
+    if (label == labels.end())
+    {
+        if (not str.empty() && str.find_first_not_of("0123456789") == string_view::npos)
+        {    // its a line number
+            return parse_number(str, 10);
+        }
 
-    copy.erase(0, open_par_pos + 1);
-    int close_par_pos = copy.find(')');
-    string op2 = copy.substr(0, close_par_pos);
+        cout << "ERROR: undefined label \"" << str << "\" on line " << line_number << "!" << endl;
+        return 0;
+    }
+    return label->second;
+}
 
-    if (str[0] != 'R')
-    {    // op1 is immediate, op2 is register
-        return op2;
+// resolves an operand that is either a label or an immediate
+int resolve_operand(const std::unordered_map<std::string, int>& labels, const string_view str)
+{
+    auto label = labels.find(string(str));
+    if (label != labels.end())
+    {    // its a label
+        return label->second;
     }
     else
-    {    // op1 is register, op2 is immediate
-        return op1;
+    {    // its an immediate
+        return resolve_immediate(str);
     }
 }
 
-// put labels into hashmap, if instruction doesnt have a label use its line number
-void fill_label_map(Program& program)
+void run_program(Memory& memory, const Options& options, const string& output_file)
 {
-    string label;
-    int line_number;
+    // the functional engine runs ahead of the pipeline, feeding it one buffer of executed instructions at a time
+    FunctionalState functional;
+    TraceSource source;
+    start_functional(functional, memory);
+    open_live_source(source, functional, memory);
+
+    run_timing(*memory.program, source, options, output_file);
+    finish_functional(functional, memory);
+}
 
-    for (unsigned int ii = 0; ii < program.instructions.size(); ii++)
+void replay_trace(const Program& program, const string& trace_file, const Options& options, const string& output_file)
+{
+    TraceSource source;
+    if (open_trace_file(source, trace_file, program))
     {
-        label = program.instructions[ii].label;
-        line_number = program.instructions[ii].line_number;
+        run_timing(program, source, options, output_file);
+    }
+}
 
-        // add every line number as a label, and the actual label if one exists
-        program.labels.insert({to_string(line_number), line_number});
-        if (not label.empty())
+// the configurations the timing loop is compiled for, --pipeline= picks one of them by name
+typedef long long (*TimingLoop)(const Program& program, TraceSource& source, const Options& options, const string& output_file);
+typedef SampleWindow (*WindowTimer)(const TraceRecord* records, const int num_records, const int num_warmup, DataCache* cache, BranchPredictor* predictor);
+struct CompiledPipeline {
+    const PipelineConfig* config;
+    TimingLoop loop;
+    TimingLoop counted_loop; // the same loop with the stall counters built in
+    WindowTimer time_window;
+};
+const CompiledPipeline COMPILED_PIPELINES[] = {
+    {&FIVE_STAGE_PIPELINE, run_pipeline<FIVE_STAGE_PIPELINE, false>, run_pipeline<FIVE_STAGE_PIPELINE, true>, time_window<FIVE_STAGE_PIPELINE>},
+    {&SEVEN_STAGE_PIPELINE, run_pipeline<SEVEN_STAGE_PIPELINE, false>, run_pipeline<SEVEN_STAGE_PIPELINE, true>, time_window<SEVEN_STAGE_PIPELINE>},
+    {&NINE_STAGE_PIPELINE, run_pipeline<NINE_STAGE_PIPELINE, false>, run_pipeline<NINE_STAGE_PIPELINE, true>, time_window<NINE_STAGE_PIPELINE>}};
+
+const PipelineConfig* find_pipeline_config(const string& name)
+{
+    for (const CompiledPipeline& compiled : COMPILED_PIPELINES)
+    {
+        if (name == compiled.config->name)
         {
-            program.labels.insert({label, line_number});
+            return compiled.config;
         }
     }
+    return nullptr;
 }
 
-// fills data memory from input file
-void load_data(vector<bitset<REG_SIZE>>& data, const string& filename)
+long long run_timing(const Program& program, TraceSource& source, const Options& options, const string& output_file)
 {
-    string line;
-    fstream file;
-    int num_words = 0;    // each line is a word (32 bits)
-
-    // load each instruction into memory, line by line
-    file.open(filename);
-    if (file.is_open())
+    for (const CompiledPipeline& compiled : COMPILED_PIPELINES)
     {
-        // count lines so we can presize data vector
-        while (!file.eof())
+        if (compiled.config == options.pipeline)
         {
-            file.ignore(256, '\n');
-            num_words++;
+            return options.stats_out_file.empty() ? compiled.loop(program, source, options, output_file) : compiled.counted_loop(program, source, options, output_file);
         }
-        data.resize(num_words);
-
-        // go back to the start of file
-        file.seekg(0);
+    }
+    cout << "ERROR: pipeline \"" << options.pipeline->name << "\" was not compiled in!" << endl;
+    return 0;
+}
 
-        // parse each line
-        for (int ii = 0; ii < num_words; ii++)
+SampleWindow time_sample_window(const TraceRecord* records, const int num_records, const int num_warmup, const Options& options, DataCache* cache, BranchPredictor* predictor)
+{
+    for (const CompiledPipeline& compiled : COMPILED_PIPELINES)
+    {
+        if (compiled.config == options.pipeline)
         {
-            file >> data[ii];
+            return compiled.time_window(records, num_records, num_warmup, cache, predictor);
         }
-
-        file.close();
-    }
-    else
-    {
-        cout << "File could not be opened!" << endl;
     }
+    cout << "ERROR: pipeline \"" << options.pipeline->name << "\" was not compiled in!" << endl;
+    return SampleWindow();
 }
 
-void run_program(Memory& memory, const string& output_file)
+// steps the pipeline cycle by cycle, placing each instruction from the source as it is fetched
+// rows are written as instructions retire, so nothing grows with the length of the run
+// returns the number of cycles simulated, counting from the checkpoint a resumed run starts at
+template <const PipelineConfig& CONFIG, bool COUNT_STALLS>
+long long run_pipeline(const Program& program, TraceSource& source, const Options& options, const string& output_file)
 {
-    vector<Instruction*> active_instrs = vector<Instruction*>(7, nullptr);
+    Pipeline pipeline;
     FlagReg flags;
-    int PC = 0;
-    int cycle = 1;
+    long long cycle = 1;
+    long long num_written = 0;
 
-    vector<bitset<REG_SIZE>> registers = vector<bitset<REG_SIZE>>(NUM_REGS, 0);
-    vector<Instruction> running_instrs;
-    running_instrs.reserve(MAX_CYCLE_LIMIT);
+    DataCache cache;
+    if (options.cache.size != 0)
+    {
+        start_cache(cache, options.cache);
+        pipeline.cache = &cache;
+    }
+    BranchPredictor predictor;
+    if (options.predictor.kind != PREDICT_NONE)
+    {
+        start_predictor(predictor, options.predictor, program.instructions.size());
+        pipeline.predictor = &predictor;
+    }
+    PipelineStats stats;
+    if constexpr (COUNT_STALLS)
+    {
+        start_stats(stats, program.original_lines.size());
+    }
 
-    while (not flags.program_complete)
+    // a resumed run picks up from the checkpoint's cycle, its table only has the instructions that retire after it
+    if (not options.checkpoint_in_file.empty())
     {
+        if (not load_checkpoint(options.checkpoint_in_file, program, CONFIG, pipeline, flags, cycle, source))
+        {
+            return 0;
+        }
+        num_written = pipeline.num_retired;
+        flags.program_complete = (flags.finishing_up && pipeline_empty<CONFIG>(pipeline)) || (options.cycle_limit != 0 && cycle > options.cycle_limit);
+    }
+    long long first_cycle = cycle;
+
+    OutputWriter output;
+    open_output(output, output_file, options.echo_output);
+    format_output_header(output.filling, CONFIG);
+    TimelineWriter timeline;
+    bool keep_timeline = not options.timeline_out_file.empty() && open_timeline_writer(timeline, options.timeline_out_file, CONFIG);
+    OccupancyWriter occupancy;
+    if (not options.occupancy_out_file.empty()
+        && open_occupancy(occupancy, options.occupancy_out_file, program, CONFIG, pipeline.active_instrs, pipeline.num_retired, cycle))
+    {
+        pipeline.occupancy = &occupancy;
+    }
 
-        // try IF, other instructions will have been pushed forward if the flag is set
-        update_flags(flags, active_instrs, running_instrs, IF);
-        if (flags.able_to_insert)
+    while (not flags.program_complete)
+    {
+        PipelineSnapshot start_of_cycle = take_snapshot(pipeline, flags);
+        CycleCauses causes;
+        if constexpr (COUNT_STALLS)
         {
+            causes = take_cycle_causes<CONFIG>(pipeline);
+        }
 
-            // put new instruction into running_instrs
-            running_instrs.push_back(get_next_filled_instruction(memory.program.instructions, PC));
+        simulate_cycle<CONFIG>(pipeline, flags, source, cycle);
 
-            // put pointer to new instruction into array of active instrs (basically stage regs)
-            running_instrs.back().instr_index = running_instrs.size() - 1;
-            running_instrs.back().in_stage = IF;
-            active_instrs[IF] = &running_instrs.back();
-            active_instrs[IF]->finish_log[IF] = cycle;
+        if constexpr (COUNT_STALLS)
+        {
+            count_cycles<CONFIG>(stats, pipeline, flags, causes, 1);
         }
 
-        // finish/execute each stage, move it to the next stage
-        for (int ii = NUM_STAGES - 1; ii >= 0; ii--)
+        // write out everything that left WB this cycle, before its slot can be reused
+        while (num_written < pipeline.num_retired)
         {
-            update_flags(flags, active_instrs, running_instrs, IF);
+            const Instruction& retired = pipeline.window[num_written % WINDOW_SIZE];
+            if constexpr (COUNT_STALLS)
+            {
+                stats.num_retired++;
+                if (retired.line_number >= 1 && (unsigned int)retired.line_number <= stats.lines.size())
+                {
+                    stats.lines[retired.line_number - 1].retired++;
+                }
+            }
+            write_output_row(output, program, retired, CONFIG);
+            if (keep_timeline)
+            {
+                write_timeline_row(timeline, timeline_row<CONFIG>(retired));
+            }
+            num_written++;
+        }
+
+        // the last instruction has left the pipeline
+        if (flags.finishing_up && pipeline_empty<CONFIG>(pipeline))
+        {
+            flags.program_complete = true;
+        }
 
-            // the instruction exists
-            if (active_instrs[ii])
+        // nothing moved, so jump to the cycle before the next one where something can
+        if (options.skip_quiet_cycles && start_of_cycle == take_snapshot(pipeline, flags))
+        {
+            long long num_quiet = quiet_cycles_ahead<CONFIG>(pipeline);
+            if (options.cycle_limit != 0)
+            {
+                num_quiet = std::min(num_quiet, options.cycle_limit - cycle);
+            }
+            if (options.checkpoint_every != 0)
             {
-                attempt_stage(memory, registers, active_instrs, running_instrs, flags, stages[ii], PC, cycle);
+                num_quiet = std::min(num_quiet, options.checkpoint_every - cycle % options.checkpoint_every);
+            }
+            if (num_quiet != NO_EVENT)
+            {
+                skip_cycles<CONFIG>(pipeline, num_quiet, cycle);
+
+                // the skipped cycles lose whatever the one that just ran did
+                if constexpr (COUNT_STALLS)
+                {
+                    count_cycles<CONFIG>(stats, pipeline, flags, causes, num_quiet);
+                }
             }
         }
 
+        // save the run at the end of every checkpoint_every'th cycle, to resume from the next one
+        if (options.checkpoint_every != 0 && cycle % options.checkpoint_every == 0)
+        {
+            write_checkpoint(options.checkpoint_out_file, program, CONFIG, pipeline, flags, cycle + 1, source);
+        }
+
         // increment PC and terminate program if limit has been reached or instructions have finished
         cycle++;
-        if (not ENABLE_UNLIMITED_INPUT && cycle > OPTIONAL_CYCLE_LIMIT)
+        if (options.cycle_limit != 0 && cycle > options.cycle_limit)
         {
             // check if limit has been reached
             flags.program_complete = true;
         }
     }
 
-    write_output(running_instrs, output_file);
-    print_output(running_instrs);
-}
-
-void update_flags(FlagReg& flags, vector<Instruction*>& active_instrs, const vector<Instruction>& running_instrs, const Stage stage)
-{
-    update_data_hazards(active_instrs, running_instrs);
-
-    // set finishing_up
-    if (active_instrs[IF] && active_instrs[IF]->exists && active_instrs[IF]->opcode == "HLT")
+    if (options.checkpoint_every == 0 && not options.checkpoint_out_file.empty())
     {
-        flags.finishing_up = true;
+        write_checkpoint(options.checkpoint_out_file, program, CONFIG, pipeline, flags, cycle, source);
     }
 
-    // set control_hazard_exists and able_to_insert
-    flags.control_hazard_exists = active_instrs[ID] && active_instrs[ID]->exists && active_instrs[ID]->is_branch;
-    flags.able_to_insert = active_instrs[IF] && not active_instrs[IF]->exists && not flags.control_hazard_exists && not flags.finishing_up;
-
-    if (not active_instrs[IF] && not flags.finishing_up)
+    // instructions still in flight when the run stopped, oldest first
+    while (num_written < pipeline.num_fetched)
     {
-        if (not active_instrs[IF] && not flags.control_hazard_exists && not flags.finishing_up)
+        const Instruction& in_flight = pipeline.window[num_written % WINDOW_SIZE];
+        write_output_row(output, program, in_flight, CONFIG);
+        if (keep_timeline)
         {
-            flags.able_to_insert = true;
+            write_timeline_row(timeline, timeline_row<CONFIG>(in_flight));
         }
-        return;
+        num_written++;
     }
 
-    // set susceptible_to_data_hazard
-    bool susceptible_to_data_hazard = false;
-    if (stage == IF)
+    // the reports follow the table, through the same writer
+    if (pipeline.cache || pipeline.predictor)
     {
-        if (active_instrs[stage] && active_instrs[stage]->is_branch)
+        std::ostringstream reports;
+        if (pipeline.cache)
         {
-            susceptible_to_data_hazard = true;
+            write_cache_report(reports, cache);
         }
-    }
-    else if (stage == ID)
-    {
-        if (active_instrs[stage] && active_instrs[stage]->has_source_regs && not active_instrs[stage]->is_branch)
+        if (pipeline.predictor)
         {
-            susceptible_to_data_hazard = true;
+            write_predictor_report(reports, predictor, program);
         }
+        write_output_text(output, reports.str());
+    }
+    close_output(output);
+    if (pipeline.occupancy)
+    {
+        close_occupancy(occupancy, pipeline.active_instrs, cycle - 1);
+    }
+    if (keep_timeline)
+    {
+        close_timeline_writer(timeline);
     }
 
-    // set has_structural_hazard and able_to_push
-    if (stage == WB)
+    if constexpr (COUNT_STALLS)
     {
-        flags.has_structural_hazard = false;
-        flags.able_to_push = true;
+        write_stats(options.stats_out_file, stats, CONFIG, program);
     }
-    else
+    return cycle - first_cycle;
+}
+
+// times the records from a cold pipeline, the first num_warmup of them only fill it and are not measured
+// measuring starts once the last warm-up instruction has retired and ends when the last record retires
+template <const PipelineConfig& CONFIG>
+SampleWindow time_window(const TraceRecord* records, const int num_records, const int num_warmup, DataCache* cache, BranchPredictor* predictor)
+{
+    Pipeline pipeline;
+    pipeline.cache = cache;
+    pipeline.predictor = predictor;
+    FlagReg flags;
+    TraceSource source;
+    open_record_source(source, records, num_records);
+
+    SampleWindow window;
+    window.num_instructions = num_records - num_warmup;
+    long long start_cycle = num_warmup == 0 ? 0 : -1;
+    long long cycle = 1;
+    while (not flags.finishing_up || not pipeline_empty<CONFIG>(pipeline))
     {
+        const Instruction* at_start[MAX_STAGES];
+        std::copy(pipeline.active_instrs, pipeline.active_instrs + MAX_STAGES, at_start);
+
+        simulate_cycle<CONFIG>(pipeline, flags, source, cycle);
 
-        flags.has_data_hazard = active_instrs[stage] && active_instrs[stage]->has_data_hazard;
+        if (start_cycle >= 0)
+        {
+            // an instruction still in its stage once the stage's latency has run out is stalled
+            for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
+            {
+                const Instruction* instr = pipeline.active_instrs[ii];
+                if (instr && instr == at_start[ii] && instr->stage_cycles >= stage_latency<CONFIG>(*instr, ii))
+                {
+                    window.stall_cycles[ii]++;
+                }
+            }
+        }
+        else if (pipeline.num_retired >= num_warmup)
+        {
+            start_cycle = cycle;
+        }
+        cycle++;
+    }
+    window.num_cycles = cycle - 1 - start_cycle;
+    return window;
+}
 
-        flags.has_structural_hazard = active_instrs[stage + 1] && active_instrs[stage + 1]->exists;
-        flags.able_to_push = not flags.has_structural_hazard && (not susceptible_to_data_hazard || not flags.has_data_hazard);
+// fetches, then runs every stage back to front for one cycle
+template <const PipelineConfig& CONFIG>
+void simulate_cycle(Pipeline& pipeline, FlagReg& flags, TraceSource& source, const long long cycle)
+{
+    Instruction** active_instrs = pipeline.active_instrs;
+    TraceRecord record;
 
-        if (stage == MEM && active_instrs[stage] && active_instrs[stage] && active_instrs[stage]->mem_count < 3)
+    // try IF, other instructions will have been pushed forward if the flag is set
+    update_fetch_flags<CONFIG>(flags, pipeline);
+    if (flags.able_to_insert)
+    {
+        if (next_record(source, record))
         {
-            flags.able_to_push = false;
+
+            // put new instruction into the next free slot of the window
+            Instruction& fetched = pipeline.window[pipeline.num_fetched % WINDOW_SIZE];
+            fetched = instruction_from_record(record);
+            fetched.instr_index = pipeline.num_fetched++;
+            fetched.in_stage = IF;
+
+            // put pointer to new instruction into array of active instrs (basically stage regs)
+            active_instrs[IF] = &fetched;
+            active_instrs[IF]->finish_log[IF] = cycle;
+            if (pipeline.occupancy)
+            {
+                occupancy_fetch(*pipeline.occupancy, fetched, cycle);
+            }
+
+            // nothing is fetched after a HLT
+            if (fetched.opcode == HLT)
+            {
+                flags.finishing_up = true;
+            }
+
+            // a branch fetch gets right is followed by the next instruction of the trace straight away
+            // one it gets wrong stops fetch until it resolves, the wrong path it would have fetched is squashed unseen
+            if (pipeline.predictor && (fetched.is_branch || fetched.opcode == J))
+            {
+                fetched.predicted = predict_branch(*pipeline.predictor, fetched.line_number - 1, fetched.opcode == J, fetched.branch_taken);
+            }
+        }
+        else
+        {
+            // ran off the end of the program without a HLT
+            flags.finishing_up = true;
         }
     }
 
-    // set is_stalling
-    if (not flags.has_structural_hazard && flags.has_data_hazard)
+    // finish/execute each stage, move it to the next stage
+    ControlSnapshot snapshot = take_control_snapshot<CONFIG>(pipeline, flags);
+    for (Stage ii = CONFIG.num_stages - 1; ii >= 0; ii--)
     {
-        flags.is_stalling = true;
+        // the instruction exists
+        if (active_instrs[ii])
+        {
+            attempt_stage<CONFIG>(pipeline, flags, snapshot, ii, cycle);
+        }
     }
-    else
+}
+
+// true once no stage holds an instruction
+template <const PipelineConfig& CONFIG>
+bool pipeline_empty(const Pipeline& pipeline)
+{
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
     {
-        flags.is_stalling = false;
+        if (pipeline.active_instrs[ii])
+        {
+            return false;
+        }
     }
+    return true;
+}
 
-    // set finish_op_this_stage
-    if (stage == ID)
+PipelineSnapshot take_snapshot(const Pipeline& pipeline, const FlagReg& flags)
+{
+    PipelineSnapshot snapshot;
+    snapshot.flags = flags;
+    snapshot.num_fetched = pipeline.num_fetched;
+    snapshot.num_changes = pipeline.num_changes;
+    return snapshot;
+}
+
+// sets one of an instruction's progress flags, counting the first time as a change to the pipeline
+void set_progress(Pipeline& pipeline, bool& progress)
+{
+    pipeline.num_changes += not progress;
+    progress = true;
+}
+
+// cycles an instruction spends in MEM, LW and SW go through the data cache when one is modelled
+// called once as it enters MEM, so the cache sees the accesses in program order
+template <const PipelineConfig& CONFIG>
+int memory_latency(Pipeline& pipeline, const Instruction& instr)
+{
+    if (pipeline.cache && (instr.opcode == LW || instr.opcode == SW))
     {
-        if (active_instrs[stage] && active_instrs[stage]->opcode == "HLT")
+        return cache_access(*pipeline.cache, instr.address, instr.opcode == SW);
+    }
+    return CONFIG.latencies[CONFIG.memory_stage()];
+}
+
+// after a cycle where nothing moved, the number of cycles that will repeat it exactly
+// the first cycle that differs is the one where an instruction sits in the last cycle of a multi cycle stage
+// NO_EVENT if no latency is running out, meaning nothing would ever change again
+template <const PipelineConfig& CONFIG>
+long long quiet_cycles_ahead(const Pipeline& pipeline)
+{
+    long long num_quiet = NO_EVENT;
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
+    {
+        const Instruction* instr = pipeline.active_instrs[ii];
+        if (not instr)
+        {
+            continue;
+        }
+        int latency = stage_latency<CONFIG>(*instr, ii);
+        if (latency > 1 && instr->stage_cycles < latency)
         {
-            flags.finish_op_this_stage = true;
+            num_quiet = std::min(num_quiet, (long long)(latency - 1 - instr->stage_cycles));
         }
     }
-    else if (stage == EX1)
+    return num_quiet;
+}
+
+// applies num_quiet repeats of the cycle that just ran, leaving cycle on the last of them
+template <const PipelineConfig& CONFIG>
+void skip_cycles(Pipeline& pipeline, const long long num_quiet, long long& cycle)
+{
+    cycle += num_quiet;
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
     {
-        if (active_instrs[stage] && (active_instrs[stage]->opcode == "J" || active_instrs[stage]->opcode == "BEQ" || active_instrs[stage]->opcode == "BNE"))
+        Instruction* instr = pipeline.active_instrs[ii];
+        if (instr)
         {
-            flags.finish_op_this_stage = true;
-            active_instrs[stage]->finish_log[EX3] = active_instrs[stage]->finish_log[ID] + 1;
+            if (not instr->has_completed)
+            {
+                instr->finish_log[ii] = cycle;
+            }
+            instr->stage_cycles += num_quiet;
         }
     }
-    else if (stage == WB)
+}
+
+// marks the result register of an instruction leaving ID as waiting on a write
+void issue_to_scoreboard(Pipeline& pipeline, const Instruction& instruction)
+{
+    if (instruction.writes_to_register)
     {
-        flags.finish_op_this_stage = true;
+        pipeline.pending_writes |= register_mask(instruction.result_reg);
+        pipeline.last_writer[instruction.result_reg] = instruction.instr_index;
     }
-    else
+}
+
+// clears the result register once written, unless a younger instruction has issued a write to it since
+void write_back_to_scoreboard(Pipeline& pipeline, const Instruction& instruction)
+{
+    if (instruction.writes_to_register && pipeline.last_writer[instruction.result_reg] == instruction.instr_index)
+    {
+        pipeline.pending_writes &= ~register_mask(instruction.result_reg);
+    }
+}
+
+// true if a source register of the instruction in the stage is still waiting on an older write
+// pending_writes is the scoreboard as the stage sees it, see pending_after_write_back()
+bool data_hazard_exists(const Pipeline& pipeline, const Stage stage, const uint32_t pending_writes)
+{
+    uint32_t waiting_on = pending_writes;
+
+    // a branch checks from IF, while the instruction right ahead of it has not issued yet
+    const Instruction* decoding = pipeline.active_instrs[ID];
+    if (stage == IF && decoding && decoding->writes_to_register)
     {
-        flags.finish_op_this_stage = false;
+        waiting_on |= register_mask(decoding->result_reg);
     }
+    return pipeline.active_instrs[stage]->source_mask & waiting_on;
+}
 
-    // set program_complete
-    if (active_instrs[ID] && active_instrs[ID]->exists && active_instrs[ID]->opcode == "HLT")
+// decides whether IF takes a new instruction this cycle, a branch or jump is unresolved until it reaches CONFIG.branch_stage
+// fetch only waits on the ones the branch predictor got wrong (every one of them without a predictor)
+template <const PipelineConfig& CONFIG>
+void update_fetch_flags(FlagReg& flags, const Pipeline& pipeline)
+{
+    const Instruction* const* active_instrs = pipeline.active_instrs;
+
+    flags.control_hazard_exists = false;
+    for (Stage ii = ID; ii < CONFIG.branch_stage; ii++)
     {
-        flags.program_complete = active_instrs[EX1] && active_instrs[EX1]->has_completed && active_instrs[EX2] && active_instrs[EX2]->has_completed && active_instrs[EX3] && active_instrs[EX3]->has_completed && active_instrs[MEM] && active_instrs[MEM]->has_completed && active_instrs[WB] && active_instrs[WB]->has_completed;
+        if (active_instrs[ii] && (active_instrs[ii]->is_branch || active_instrs[ii]->opcode == J) && not active_instrs[ii]->predicted)
+        {
+            flags.control_hazard_exists = true;
+        }
     }
+    flags.able_to_insert = not active_instrs[IF] && not flags.control_hazard_exists && not flags.finishing_up;
 }
 
-Instruction get_next_filled_instruction(const vector<Instruction>& instructions, int& PC)
+// the scoreboard as ID and IF see it, WB writes its result before either of them checks theirs
+template <const PipelineConfig& CONFIG>
+uint32_t pending_after_write_back(const Pipeline& pipeline)
 {
-    Instruction cur_instr;
-    if ((unsigned int)PC > instructions.size() - 1)
+    const Instruction* writing_back = pipeline.active_instrs[CONFIG.writeback_stage()];
+    if (writing_back && writing_back->writes_to_register && pipeline.last_writer[writing_back->result_reg] == writing_back->instr_index)
     {
-        cout << "ERROR: PC is out of bounds!" << endl;
-        return cur_instr;
+        return pipeline.pending_writes & ~register_mask(writing_back->result_reg);
     }
-    else
-        while ((unsigned int)PC < instructions.size())
+    return pipeline.pending_writes;
+}
+
+// works out what every stage may do this cycle, before any of them runs
+// a stage is only ever held up by the one ahead of it, so the stages can then run back to front on lookups alone
+template <const PipelineConfig& CONFIG>
+ControlSnapshot take_control_snapshot(const Pipeline& pipeline, const FlagReg& flags)
+{
+    const Instruction* const* active_instrs = pipeline.active_instrs;
+    ControlSnapshot snapshot;
+
+    // with nothing in IF the stages have never been given decisions of their own, they keep the last one made
+    snapshot.frozen = not active_instrs[IF] && not flags.finishing_up;
+
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
+    {
+        const Instruction* instr = active_instrs[ii];
+        if (not instr)
         {
-            cur_instr = instructions[PC];
-            PC++;
+            continue;
+        }
+        snapshot.occupied |= stage_mask(ii);
 
-            if (cur_instr.exists)
-            {
-                return cur_instr;
-            }
+        // single cycle stages never hold an instruction back, stage_cycles counts this cycle before the decision
+        int latency = stage_latency<CONFIG>(*instr, ii);
+        if (latency > 1 && instr->stage_cycles + 1 < latency)
+        {
+            snapshot.held |= stage_mask(ii);
+        }
+
+        if ((ii == CONFIG.halt_stage && instr->opcode == HLT) || (ii == CONFIG.branch_stage && (instr->is_branch || instr->opcode == J)) || ii == CONFIG.writeback_stage())
+        {
+            snapshot.finishing |= stage_mask(ii);
         }
-    return cur_instr;
+    }
+
+    snapshot.held |= data_hazard_stages<CONFIG>(pipeline);
+    return snapshot;
 }
 
-void attempt_stage(Memory& memory, vector<bitset<REG_SIZE>>& registers, vector<Instruction*>& active_instrs, const vector<Instruction>& running_instrs, FlagReg& flags, Stage stage, int& PC, const int cycle)
+// bit per stage whose instruction has to wait for a source register this cycle
+// branches check their sources from IF, everything else from ID
+template <const PipelineConfig& CONFIG>
+uint32_t data_hazard_stages(const Pipeline& pipeline)
 {
-    string arg1 = active_instrs[stage]->arg1;
-    string arg2 = active_instrs[stage]->arg2;
-    string arg3 = active_instrs[stage]->arg3;
+    const Instruction* const* active_instrs = pipeline.active_instrs;
+    uint32_t pending_writes = pending_after_write_back<CONFIG>(pipeline);
+    uint32_t stages = 0;
+    if (active_instrs[IF] && active_instrs[IF]->is_branch && data_hazard_exists(pipeline, IF, pending_writes))
+    {
+        stages |= stage_mask(IF);
+    }
+    if (active_instrs[ID] && active_instrs[ID]->has_source_regs && not active_instrs[ID]->is_branch && data_hazard_exists(pipeline, ID, pending_writes))
+    {
+        stages |= stage_mask(ID);
+    }
+    return stages;
+}
 
-    update_flags(flags, active_instrs, running_instrs, stage);
-    int opcode = VALID_OPCODES.at(active_instrs[stage]->opcode);
-    switch (opcode)
+template <const PipelineConfig& CONFIG>
+CycleCauses take_cycle_causes(const Pipeline& pipeline)
+{
+    const Instruction* const* active_instrs = pipeline.active_instrs;
+    CycleCauses causes;
+    std::copy(active_instrs, active_instrs + MAX_STAGES, causes.instrs);
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
     {
-    case LW:    // {rd, #(rs)}
-        if (stage == WB)
+        if (active_instrs[ii])
         {
-            registers[VALID_REGISTERS.at(arg1)] = get_value(memory, registers, arg2);
-            active_instrs[stage]->already_wrote_result = true;
+            causes.occupied |= stage_mask(ii);
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
-        break;
+    }
+    causes.data_held = data_hazard_stages<CONFIG>(pipeline);
 
-    case SW:    // {rs, #(rt)}
-        if (stage == MEM && active_instrs[stage]->mem_count >= 3)
+    const Instruction* accessing = active_instrs[CONFIG.memory_stage()];
+    causes.memory_busy = accessing && accessing->stage_cycles + 1 < stage_latency<CONFIG>(*accessing, CONFIG.memory_stage());
+
+    // the same branches update_fetch_flags() waits on
+    for (Stage ii = ID; ii < CONFIG.branch_stage; ii++)
+    {
+        if (active_instrs[ii] && (active_instrs[ii]->is_branch || active_instrs[ii]->opcode == J) && not active_instrs[ii]->predicted)
         {
-            memory.data[address_to_index(registers, arg2)] = get_value(memory, registers, arg1);
-            active_instrs[stage]->already_wrote_result = true;
+            causes.unresolved_branch = active_instrs[ii];
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
-        break;
+    }
+    return causes;
+}
 
-    case LI:    // {rd, #}
-        if (stage == WB)
+// charges num_cycles cycles that ran (or were skipped) from causes to the stages and lines that lost them
+// an instruction loses a cycle once it is still in its stage after the stage's latency, as the sampled stall counts do
+template <const PipelineConfig& CONFIG>
+void count_cycles(PipelineStats& stats, const Pipeline& pipeline, const FlagReg& flags, const CycleCauses& causes, const long long num_cycles)
+{
+    stats.num_cycles += num_cycles;
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
+    {
+        const Instruction* instr = pipeline.active_instrs[ii];
+        StallReason reason;
+        const Instruction* charged = instr;
+        if (instr)
+        {
+            stats.stages[ii].occupied += num_cycles;
+            if (instr != causes.instrs[ii] || instr->stage_cycles < stage_latency<CONFIG>(*instr, ii))
+            {
+                continue;
+            }
+
+            // held by the stage ahead, which may be waiting on MEM further up
+            Stage blocking = ii + 1;
+            while (blocking < CONFIG.memory_stage() && (causes.occupied & stage_mask(blocking)))
+            {
+                blocking++;
+            }
+            if (causes.data_held & stage_mask(ii))
+            {
+                reason = STALL_DATA;
+            }
+            else if (causes.memory_busy && blocking == CONFIG.memory_stage())
+            {
+                reason = STALL_MEMORY;
+            }
+            else
+            {
+                reason = STALL_STRUCTURAL;
+            }
+        }
+        else if (ii == IF && not causes.instrs[IF] && flags.control_hazard_exists && not flags.finishing_up)
         {
-            registers[VALID_REGISTERS.at(arg1)] = resolve_immediate(arg2);
-            active_instrs[stage]->already_wrote_result = true;
+            reason = STALL_CONTROL;
+            charged = causes.unresolved_branch;
+        }
+        else
+        {
+            continue;
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
-        break;
 
-    case ADD:     // {rd, rs, rt}
-    case ADDI:    // {rd, rs, #}
-        if (stage == WB)
+        stats.stages[ii].stalls[reason] += num_cycles;
+        if (charged && charged->line_number >= 1 && (unsigned int)charged->line_number <= stats.lines.size())
         {
-            registers[VALID_REGISTERS.at(arg1)] = get_value(memory, registers, arg2) + get_value(memory, registers, arg3);
-            active_instrs[stage]->already_wrote_result = true;
+            stats.lines[charged->line_number - 1].stalls[reason] += num_cycles;
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
-        break;
+    }
+}
 
+// the row --timeline-out= keeps for an instruction, its stalls are the cycles it finished each stage after ID late by
+template <const PipelineConfig& CONFIG>
+TimelineRow timeline_row(const Instruction& instr)
+{
+    TimelineRow row;
+    row.instr_index = instr.instr_index;
+    row.line_number = instr.line_number;
+    for (Stage ii = 0; ii < CONFIG.num_stages; ii++)
+    {
+        row.finish_log[ii] = instr.finish_log[ii];
+        if (ii != IF && instr.finish_log[ii] != 0 && instr.finish_log[ii - 1] != 0)
+        {
+            row.stalls += std::max(0LL, instr.finish_log[ii] - instr.finish_log[ii - 1] - stage_latency<CONFIG>(instr, ii));
+        }
+    }
+    return row;
+}
+
+// the values an instruction produces come from the functional engine that fed it in
+// here only the timing side effects are applied: when results become visible, and when branches resolve
+template <const PipelineConfig& CONFIG>
+void attempt_stage(Pipeline& pipeline, FlagReg& flags, ControlSnapshot& snapshot, const Stage stage, const long long cycle)
+{
+    Instruction* instr = pipeline.active_instrs[stage];
+
+    switch (instr->opcode)
+    {
+    case LW:       // {rd, #(rs)}
+    case LI:       // {rd, #}
+    case ADD:      // {rd, rs, rt}
+    case ADDI:     // {rd, rs, #}
     case MULT:     // {rd, rs, rt}
     case MULTI:    // {rd, rs, #}
-        if (stage == WB)
+    case SUB:      // {rd, rs, rt}
+    case SUBI:     // {rd, rs, #}
+        if (stage == CONFIG.writeback_stage())
         {
-            registers[VALID_REGISTERS.at(arg1)] = get_value(memory, registers, arg2) * get_value(memory, registers, arg3);
-            active_instrs[stage]->already_wrote_result = true;
+            set_progress(pipeline, instr->already_wrote_result);
+            write_back_to_scoreboard(pipeline, *instr);
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
+        attempt_push<CONFIG>(pipeline, flags, snapshot, stage, cycle);
         break;
 
-    case SUB:     // {rd, rs, rt}
-    case SUBI:    // {rd, rs, #}
-        if (stage == WB)
+    case SW:    // {rs, #(rt)}
+        if (stage == CONFIG.memory_stage() && instr->stage_cycles == instr->mem_latency - 1)
         {
-            registers[VALID_REGISTERS.at(arg1)] = get_value(memory, registers, arg2) - get_value(memory, registers, arg3);
-            active_instrs[stage]->already_wrote_result = true;
+            set_progress(pipeline, instr->already_wrote_result);
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
+        attempt_push<CONFIG>(pipeline, flags, snapshot, stage, cycle);
         break;
 
     case BEQ:    // {rs, rt, label/#}
-        if (stage == ID)
+    case BNE:    // {rs, rt, label/#}
+    case J:      // {label/#}
+        if (stage == CONFIG.branch_stage - 1)
         {
-            if (get_value(memory, registers, arg1) == get_value(memory, registers, arg2))
+            if (instr->branch_taken)
             {
-                PC = memory.program.labels.at(arg3);
-                active_instrs[stage]->finish_log[EX3] = active_instrs[stage]->finish_log[EX1] + 1;
+                instr->finish_log[CONFIG.last_execute_stage()] = instr->finish_log[CONFIG.branch_stage] + 1;
             }
         }
-        else if (stage == EX1)
+        else if (stage == CONFIG.branch_stage)
         {
-            active_instrs[stage]->has_completed = true;
-        }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
-        break;
-
-    case BNE:    // {rs, rt, label/#}
-        if (stage == ID)
-        {
-            if (get_value(memory, registers, arg1) != get_value(memory, registers, arg2))
+            if (not snapshot.frozen)
             {
-                PC = memory.program.labels.at(arg3) - 1;
-                active_instrs[stage]->finish_log[EX3] = active_instrs[stage]->finish_log[EX1] + 1;
+                instr->finish_log[CONFIG.last_execute_stage()] = instr->finish_log[stage - 1] + 1;
             }
+            set_progress(pipeline, instr->has_completed);
         }
-        else if (stage == EX1)
-        {
-            active_instrs[stage]->has_completed = true;
-        }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
+        attempt_push<CONFIG>(pipeline, flags, snapshot, stage, cycle);
         break;
 
-    case J:    // {label/#}
-        if (stage == ID)
-        {
-            PC = memory.program.labels.at(arg3) - 1;
-            active_instrs[stage]->finish_log[EX3] = active_instrs[stage]->finish_log[EX1] + 1;
-        }
-        else if (stage == EX1)
+    case HLT:    // {}
+        if (stage == CONFIG.halt_stage + 1)
         {
-            active_instrs[stage]->has_completed = true;
+            set_progress(pipeline, instr->has_completed);
         }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
+        attempt_push<CONFIG>(pipeline, flags, snapshot, stage, cycle);
         break;
 
-    case HLT:    // {}
-        if (stage == EX1)
-        {
-            active_instrs[stage]->has_completed = true;
-        }
-        attempt_push(active_instrs, running_instrs, flags, stage, cycle);
+    case NOP:
+        attempt_push<CONFIG>(pipeline, flags, snapshot, stage, cycle);
         break;
     };
 }
 
-// returns the integer value of any argument
-int get_value(const Memory& memory, const vector<bitset<REG_SIZE>>& registers, const string& str)
+// converts hex and decimal strings to decimal values
+// use when decoding instructions that have an immediate operand
+int resolve_immediate(const string_view str)
 {
-    int left_pos = str.find('(');
-    int right_pos = str.find(')');
-
-    if (VALID_REGISTERS.contains(str))
-    {    // its a register
-        return registers.at(VALID_REGISTERS.at(str)).to_ullong();
-    }
-    else if (left_pos != -1 && right_pos != -1)
-    {    // its an address
-        return resolve_address(memory.data, registers, str);
-    }
-    else if (memory.program.labels.contains(str))
-    {    // its a label (happens to handle some immediates)
-        return memory.program.labels.at(str);
+    size_t H_pos = str.find('H');
+    if (H_pos != string_view::npos)
+    {    // immediate is in hex
+        return parse_number(str.substr(0, H_pos), 16);
     }
     else
-    {    // its an immediate
-        return resolve_immediate(str);
+    {    // number string is already in decimal
+        return parse_number(str, 10);
     }
 }
 
-// calculates the address given by register/offset pairs
-// use for instructions that access data memory
-int resolve_address(const vector<bitset<REG_SIZE>>& data, const vector<bitset<REG_SIZE>>& registers, const string& str)
+// reads the number at the start of str like stoi() does, but prints an error instead of throwing
+int parse_number(string_view str, const int base)
 {
-    int index = address_to_index(registers, str);
-    return data[index].to_ullong();
-}
-
-// converts the address string into an index for data
-int address_to_index(const vector<bitset<REG_SIZE>>& registers, const string& str)
-{
-    int open_par_pos = str.find('(');
-    int close_par_pos = str.find(')');
-    string op1 = str.substr(0, open_par_pos);
-    string op2 = str.substr(open_par_pos + 1, close_par_pos - op1.length() - 1);
-
-    int val1, val2;
-    if (str[0] != 'R')
-    {    // op1 is immediate, op2 is register
-        val1 = stoi(op1, NULL, 10);
-        val2 = registers[VALID_REGISTERS.at(op2)].to_ullong();
+    if (str.starts_with('+'))
+    {
+        str.remove_prefix(1);
     }
-    else
-    {    // op1 is register, op2 is immediate
-        val1 = registers[VALID_REGISTERS.at(op1)].to_ullong();
-        val2 = stoi(op2, NULL, 10);
+    if (base == 16 && (str.starts_with("0X") || str.starts_with("-0X")))
+    {    // stoi() skips the prefix for base 16, keep the sign in front of the digits
+        string_view digits = str.substr(str.find('X') + 1);
+        return str[0] == '-' ? -parse_number(digits, 16) : parse_number(digits, 16);
     }
 
-    int address = val1 + val2;
-    int index = (address - 256) / 4;
-    return index;
-}
-
-// converts hex and decimal strings to decimal values
-// use when executing instructions that have an immediate operand
-int resolve_immediate(const string& str)
-{
-    int H_pos = str.find('H');
-    if (H_pos != -1)
-    {    // immediate is in hex
-        string number_portion = str.substr(0, H_pos);
-        return stoi(number_portion, NULL, 16);
-    }
-    else
-    {    // number string is already in decimal
-        return stoi(str, NULL, 10);
+    int value = 0;
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.length(), value, base);
+    if (error != std::errc())
+    {
+        cout << "ERROR: invalid number \"" << str << "\"!" << endl;
+        return 0;
     }
+    return value;
 }
 
 // increments finish_log entry and pushed forward if flags.able_to_push is set
-void attempt_push(vector<Instruction*>& active_instrs, const vector<Instruction>& running_instrs, FlagReg& flags, const Stage stage, const int cycle)
+template <const PipelineConfig& CONFIG>
+void attempt_push(Pipeline& pipeline, FlagReg& flags, ControlSnapshot& snapshot, const Stage stage, const long long cycle)
 {
-    Instruction cur_instr = *active_instrs[stage];
+    Instruction** active_instrs = pipeline.active_instrs;
 
     if (not active_instrs[stage]->has_completed)
     {
         active_instrs[stage]->finish_log[stage] = cycle;
     }
+    active_instrs[stage]->stage_cycles++;
 
-    if (stage == MEM)
+    // the stage ahead has already run this cycle, so the snapshot says whether it is free
+    if (not snapshot.frozen)
     {
-        active_instrs[stage]->mem_count++;
+        bool is_last_stage = stage == CONFIG.writeback_stage();
+        flags.able_to_push = is_last_stage || (not (snapshot.held & stage_mask(stage)) && not (snapshot.occupied & stage_mask(stage + 1)));
+        flags.finish_op_this_stage = snapshot.finishing & stage_mask(stage);
     }
 
-    update_flags(flags, active_instrs, running_instrs, stage);
+    if (pipeline.occupancy && not flags.able_to_push && active_instrs[stage]->stage_cycles >= stage_latency<CONFIG>(*active_instrs[stage], stage))
+    {
+        occupancy_stall(*pipeline.occupancy, *active_instrs[stage], stage, cycle);
+    }
 
     if (flags.able_to_push)
     {
+        pipeline.num_changes++;
+        if (pipeline.occupancy)
+        {
+            occupancy_push(*pipeline.occupancy, *active_instrs[stage], stage, cycle);
+        }
 
         if (flags.finish_op_this_stage)
         {
             active_instrs[stage]->has_completed = true;
         }
 
-        if (stage != WB)
+        if (stage == ID)
+        {
+            issue_to_scoreboard(pipeline, *active_instrs[stage]);
+        }
+
+        if (stage != CONFIG.writeback_stage())
         {
             active_instrs[stage + 1] = active_instrs[stage];
-            active_instrs[stage + 1]->in_stage = stages[stage + 1];
+            active_instrs[stage + 1]->in_stage = stage + 1;
+            active_instrs[stage + 1]->stage_cycles = 0;
             active_instrs[stage] = nullptr;
+            if (stage + 1 == CONFIG.memory_stage())
+            {
+                active_instrs[stage + 1]->mem_latency = memory_latency<CONFIG>(pipeline, *active_instrs[stage + 1]);
+            }
+            snapshot.occupied = (snapshot.occupied & ~stage_mask(stage)) | stage_mask(stage + 1);
         }
         else
         {
+            // leaving WB retires the instruction, its slot in the window can be reused
+            pipeline.num_retired = active_instrs[stage]->instr_index + 1;
             active_instrs[stage] = nullptr;
+            snapshot.occupied &= ~stage_mask(stage);
         }
     }
 }
 
-void update_data_hazards(vector<Instruction*>& active_instrs, const vector<Instruction>& running_instrs)
+// writes the register file and data memory, the data is written in the same format it is loaded from
+void write_state(const Memory& memory, const string& output_file)
 {
-    // for each active instruction past IF
-    for (int ii = NUM_STAGES - 1; ii >= 1; ii--)
-    {
-
-        //// compare cur_instr against new_instr
-        // active instruction writes to a result regiser
-        if (active_instrs[IF] && active_instrs[ii] && active_instrs[IF]->exists && active_instrs[ii]->exists && active_instrs[ii]->writes_to_register)
-        {
+    ofstream file;
+    file.open(output_file, ofstream::trunc);
 
-            // result register matches one of the source registers in IF, (data hazard)
-            if (active_instrs[ii]->result_reg == active_instrs[IF]->source_reg1 || active_instrs[ii]->result_reg == active_instrs[IF]->source_reg1)
-            {
+    file << "Registers" << endl;
+    for (int ii = 0; ii < NUM_REGS; ii++)
+    {
+        file << "R" << ii << "\t" << memory.registers[ii].to_string() << "\t" << memory.registers[ii].to_ulong() << endl;
+    }
 
-                // data hazard has already been cleared
-                if (active_instrs[ii]->already_wrote_result)
-                {
-                    active_instrs[IF]->has_data_hazard = false;
-                }
-                // data hazard still exists
-                else
-                {
-                    active_instrs[IF]->has_data_hazard = true;
-                    active_instrs[IF]->nearest_data_hazard = active_instrs[ii]->instr_index;
-                }
-            }
-        }
+    file << "Data" << endl;
+    for (uint32_t ii = 0; ii < memory.data.num_segment_words; ii++)
+    {
+        file << bitset<REG_SIZE>(peek_word(memory.data, DATA_SEGMENT_START + ii * 4)).to_string() << "\n";
     }
 
-    //// compare cur_instr against its nearest data hazard
-    for (int ii = NUM_STAGES - 1; ii >= 0; ii--)
+    // stores outside the data file's words have no line of their own, they are listed by address
+    uint32_t segment_end = DATA_SEGMENT_START + memory.data.num_segment_words * 4;
+    bool listed_outside = false;
+    for (uint32_t page_number : resident_pages(memory.data))
     {
-        if (active_instrs[IF] && active_instrs[ii] && active_instrs[ii]->exists && active_instrs[ii]->has_data_hazard)
+        for (int ii = 0; ii < WORDS_PER_PAGE; ii++)
         {
-            int hazard_index = active_instrs[IF]->instr_index - active_instrs[ii]->nearest_data_hazard;
-
-            // cur_instr's data hazard already made it through pipeline
-            if (hazard_index > NUM_STAGES - 1)
+            uint32_t address = (page_number << PAGE_BITS) + ii * 4;
+            uint32_t word = peek_word(memory.data, address);
+            if (word == 0 || (address >= DATA_SEGMENT_START && address < segment_end))
             {
-                active_instrs[ii]->has_data_hazard = false;
+                continue;
             }
-
-            // cur_instr's data hazard already wrote their result
-            if (running_instrs[active_instrs[ii]->nearest_data_hazard].already_wrote_result)
+            if (not listed_outside)
             {
-                active_instrs[ii]->has_data_hazard = false;
+                file << "Data outside the data file" << endl;
+                listed_outside = true;
             }
+            file << address << "\t" << bitset<REG_SIZE>(word).to_string() << "\n";
         }
     }
-}
-
-void write_output(const vector<Instruction>& instruction_history, const string& output_file)
-{
-    ofstream file;
-    file.open(output_file, ofstream::trunc);
-
-    const Instruction* cur;
-    int length;
-    int pad_length;
-
-    file << "Cycle Number for Each Stage        IF\tID\tEX3\tMEM\tWB" << endl;
-    for (unsigned int ii = 0; ii < instruction_history.size(); ii++)
-    {
-        cur = &instruction_history[ii];
-        file << cur->original_line;
-
-        // pad everything to 35 spaces, then align with tabs
-        length = cur->original_line.length();
-        pad_length = NUM_PAD_SPACES - length;
-        for (int jj = 0; jj < pad_length; jj++)
-        {
-            file << " ";
-        }
-
-        file << cur->finish_log[0] << "\t"
-             << cur->finish_log[1] << "\t"
-             << cur->finish_log[4] << "\t"
-             << cur->finish_log[5] << "\t"
-             << cur->finish_log[6] << endl;
-    }
 
     file.close();
 }
 
-void print_output(const vector<Instruction>& instruction_history)
+// looks up the text an instruction was parsed from, empty if it never came from a line
+const string& get_original_line(const Program& program, const Instruction& instruction)
 {
-    const Instruction* cur;
-    int length;
-    int pad_length;
-
-    cout << "Cycle Number for Each Stage        IF\tID\tEX3\tMEM\tWB" << endl;
-    for (unsigned int ii = 0; ii < instruction_history.size(); ii++)
+    static const string EMPTY_LINE = "";
+    if (instruction.line_number < 1 || (unsigned int)instruction.line_number > program.original_lines.size())
     {
-        cur = &instruction_history[ii];
-        cout << cur->original_line;
-
-        // pad everything to 35 spaces, then align with tabs
-        length = cur->original_line.length();
-        pad_length = NUM_PAD_SPACES - length;
-        for (int jj = 0; jj < pad_length; jj++)
-        {
-            cout << " ";
-        }
-
-        cout << cur->finish_log[0] << "\t"
-             << cur->finish_log[1] << "\t"
-             << cur->finish_log[4] << "\t"
-             << cur->finish_log[5] << "\t"
-             << cur->finish_log[6] << endl;
+        return EMPTY_LINE;
     }
+    return program.original_lines[instruction.line_number - 1];
 }
 
 
@@ -892,16 +1137,15 @@ void print_instruction(const Instruction& instruction)
     cout << "----------------------------------------" << endl;
     cout << "-- PARSED VARIABLES --" << endl;
     cout << "line_number:{" << instruction.line_number << "}" << endl;
-    cout << "original_line:{" << instruction.original_line << "}" << endl;
-    cout << "label:{" << instruction.label << "}" << endl;
     cout << "opcode:{" << instruction.opcode << "}" << endl;
-    cout << "arg1:{" << instruction.arg1 << "}" << endl;
-    cout << "arg2:{" << instruction.arg2 << "}" << endl;
-    cout << "arg3:{" << instruction.arg3 << "}" << endl;
+    cout << "result_reg:{" << instruction.result_reg << "}" << endl;
+    cout << "source_reg1:{" << instruction.source_reg1 << "}" << endl;
+    cout << "source_reg2:{" << instruction.source_reg2 << "}" << endl;
+    cout << "immediate:{" << instruction.immediate << "}" << endl;
+    cout << "target:{" << instruction.target << "}" << endl;
     cout << "-- EXECUTION VARIABLES --" << endl;
     cout << "has_completed:{" << instruction.has_completed << "}" << endl;
-    cout << "has_data_hazard:{" << instruction.has_data_hazard << "}" << endl;
-    cout << "nearest_data_hazard:{" << instruction.nearest_data_hazard << "}" << endl;
+    cout << "source_mask:{" << bitset<NUM_REGS>(instruction.source_mask) << "}" << endl;
     cout << "in_stage:{" << instruction.in_stage << "}" << endl;
     cout << "-- DOCUMENTATION VARIABLES --" << endl;
     cout << "finished_IF_at:{" << instruction.finish_log[0] << "}" << endl;
@@ -1,69 +1,91 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <istream>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <unordered_map>
 #include "instruction.hpp"
 #include "memory.hpp"
 #include "flag_reg.hpp"
+#include "trace.hpp"
+#include "pipeline.hpp"
+#include "options.hpp"
+#include "sampling.hpp"
+#include "stats.hpp"
+#include "timeline.hpp"
 
-// used to confirm valid opcodes during parsing
-// maps opcodes onto integer enums, improving readability
-const std::unordered_map<std::string, OPCODE> VALID_OPCODES = {
-    {"LW", LW}, {"SW", SW}, {"LI", LI},
-    {"ADD", ADD}, {"ADDI", ADDI},
-    {"MULT", MULT}, {"MULTI", MULTI},
-    {"SUB", SUB}, {"SUBI", SUBI},
-    {"BEQ", BEQ}, {"BNE", BNE}, {"J", J},
-    {"HLT", HLT}};
-
-// used to quickly convert string register operands into register indices
-const std::unordered_map<std::string, int> VALID_REGISTERS = {
-    {"R0", 0}, {"R1", 1}, {"R2", 2}, {"R3", 3},
-    {"R4", 4}, {"R5", 5}, {"R6", 6}, {"R7", 7},
-    {"R8", 8}, {"R9", 9}, {"R10", 10}, {"R11", 11},
-    {"R12", 12}, {"R13", 13}, {"R14", 14}, {"R15", 15},
-    {"R16", 16}, {"R17", 17}, {"R18", 18}, {"R19", 19},
-    {"R20", 20}, {"R21", 21}, {"R22", 22}, {"R23", 23},
-    {"R24", 24}, {"R25", 25}, {"R26", 26}, {"R27", 27},
-    {"R28", 28}, {"R29", 29}, {"R30", 30}, {"R31", 31}};
+// used to recognise opcodes during parsing, maps opcodes onto integer enums
+// longer names come first, so that "ADDI" is not read as "ADD"
+const std::pair<std::string_view, OPCODE> OPCODE_NAMES[] = {
+    {"MULTI", MULTI}, {"ADDI", ADDI}, {"MULT", MULT}, {"SUBI", SUBI},
+    {"ADD", ADD}, {"SUB", SUB}, {"BEQ", BEQ}, {"BNE", BNE}, {"HLT", HLT},
+    {"LW", LW}, {"SW", SW}, {"LI", LI}, {"J", J}};
 
 // high level parsing functions
 void load_program(Program& program, const std::string& filename);
+void load_program(Program& program, std::istream& in);
 void load_data(std::vector<std::bitset<REG_SIZE>>& data, const std::string& filename);
 
-// helper parsing functions
-void read_instruction_line(Instruction& instruction, std::string& line, const int line_number);
-void extract_label(Instruction& instruction, std::string& line);
-void extract_opcode(Instruction& instruction, std::string& line);
-void extract_arguments(Instruction& instruction, std::string& line);
-std::string extract_next_argument(std::string& line);
-void fill_label_map(Program& program);
-std::string get_register_from_address(const std::string& str);
+// helper parsing functions, lexing itself lives in lexer.cpp
+void fill_label_map(Program& program, const std::vector<InstructionText>& texts);
+
+// decoding functions, turn parsed text into the form the pipeline runs on
+void decode_instruction(Instruction& instruction, const InstructionText& text, const std::unordered_map<std::string, int>& labels);
+void decode_address(const std::string_view str, int& base_reg, int& offset);
+int parse_register(const std::string_view str);
+int register_index(const std::string_view str);
+int resolve_label(const std::unordered_map<std::string, int>& labels, const std::string_view str, const int line_number);
+int resolve_operand(const std::unordered_map<std::string, int>& labels, const std::string_view str);
+int resolve_immediate(const std::string_view str);
+int parse_number(std::string_view str, const int base);
 
 // utility functions called in helper parsing functions
-void remove_CR_and_LF(std::string& line);
-void remove_bars(std::string& line);
-void make_uppercase(std::string& line);
 void trim_line(std::string& line);
 
 // functions for running loaded program
-void run_program(Memory& memory, const std::string& output_file);
-Instruction get_next_filled_instruction(const std::vector<Instruction>& instructions, int& PC);
-void update_flags(FlagReg& flags, std::vector<Instruction*>& active_instrs, const std::vector<Instruction>& running_instrs, const Stage stage);
-void update_data_hazards(std::vector<Instruction*>& active_instrs, const std::vector<Instruction>& running_instrs);
-void attempt_stage(Memory& memory, std::vector<std::bitset<REG_SIZE>>& registers, std::vector<Instruction*>& active_instrs, const std::vector<Instruction>& running_instrs, FlagReg& flags, const Stage stage, int& PC, const int cycle);
-void attempt_push(std::vector<Instruction*>& active_instrs, const std::vector<Instruction>& running_instrs, FlagReg& flags, const Stage stage, const int cycle);
+void run_program(Memory& memory, const Options& options, const std::string& output_file);
+void replay_trace(const Program& program, const std::string& trace_file, const Options& options, const std::string& output_file);
+long long run_timing(const Program& program, TraceSource& source, const Options& options, const std::string& output_file);
+const PipelineConfig* find_pipeline_config(const std::string& name);
+SampleWindow time_sample_window(const TraceRecord* records, const int num_records, const int num_warmup, const Options& options, DataCache* cache, BranchPredictor* predictor);
+void issue_to_scoreboard(Pipeline& pipeline, const Instruction& instruction);
+void write_back_to_scoreboard(Pipeline& pipeline, const Instruction& instruction);
+bool data_hazard_exists(const Pipeline& pipeline, const Stage stage, const uint32_t pending_writes);
+PipelineSnapshot take_snapshot(const Pipeline& pipeline, const FlagReg& flags);
+void set_progress(Pipeline& pipeline, bool& progress);
 
-// output functions
-void write_output(const std::vector<Instruction>& instruction_history, const std::string& output_file);
-void print_output(const std::vector<Instruction>& instruction_history);
+// the timing model, instantiated for each configuration in COMPILED_PIPELINES (utils.cpp)
+// COUNT_STALLS builds in the PipelineStats counters, without it they are compiled out of the loop
+template <const PipelineConfig& CONFIG, bool COUNT_STALLS> long long run_pipeline(const Program& program, TraceSource& source, const Options& options, const std::string& output_file);
+template <const PipelineConfig& CONFIG> SampleWindow time_window(const TraceRecord* records, const int num_records, const int num_warmup, DataCache* cache, BranchPredictor* predictor);
+template <const PipelineConfig& CONFIG> void simulate_cycle(Pipeline& pipeline, FlagReg& flags, TraceSource& source, const long long cycle);
+template <const PipelineConfig& CONFIG> bool pipeline_empty(const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> int memory_latency(Pipeline& pipeline, const Instruction& instr);
+template <const PipelineConfig& CONFIG> long long quiet_cycles_ahead(const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> void skip_cycles(Pipeline& pipeline, const long long num_quiet, long long& cycle);
+template <const PipelineConfig& CONFIG> void update_fetch_flags(FlagReg& flags, const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> uint32_t pending_after_write_back(const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> uint32_t data_hazard_stages(const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> ControlSnapshot take_control_snapshot(const Pipeline& pipeline, const FlagReg& flags);
+template <const PipelineConfig& CONFIG> CycleCauses take_cycle_causes(const Pipeline& pipeline);
+template <const PipelineConfig& CONFIG> void count_cycles(PipelineStats& stats, const Pipeline& pipeline, const FlagReg& flags, const CycleCauses& causes, const long long num_cycles);
+template <const PipelineConfig& CONFIG> TimelineRow timeline_row(const Instruction& instr);
+template <const PipelineConfig& CONFIG> void attempt_stage(Pipeline& pipeline, FlagReg& flags, ControlSnapshot& snapshot, const Stage stage, const long long cycle);
+template <const PipelineConfig& CONFIG> void attempt_push(Pipeline& pipeline, FlagReg& flags, ControlSnapshot& snapshot, const Stage stage, const long long cycle);
 
-// utility functions for working with string operands
-int get_value(const Memory& memory, const std::vector<std::bitset<REG_SIZE>>& registers, const std::string& str);
-int resolve_address(const std::vector<std::bitset<REG_SIZE>>& data, const std::vector<std::bitset<REG_SIZE>>& registers, const std::string& str);
-int address_to_index(const std::vector<std::bitset<REG_SIZE>>& registers, const std::string& str);
-int resolve_immediate(const std::string& str);
+// cycles an instruction spends in a stage, MEM's was decided as it entered (see memory_latency())
+template <const PipelineConfig& CONFIG>
+inline int stage_latency(const Instruction& instr, const Stage stage)
+{
+    return stage == CONFIG.memory_stage() ? instr.mem_latency : CONFIG.latencies[stage];
+}
+
+// output functions
+const std::string& get_original_line(const Program& program, const Instruction& instruction);
+void write_state(const Memory& memory, const std::string& output_file);
 
 // debugging functions
 void print_instruction(const Instruction& instruction);